@@ -0,0 +1,409 @@
+#include "Benchmark.hpp"
+
+SourceGenerator::SourceGenerator(SourceShape shape, unsigned int seed) {
+	this->shape = shape;
+	this->random = mt19937(seed);
+	
+	// a pool of identifiers of mixed lengths, declared up front
+	static const char* stems[] = { "count", "total", "index", "value", "result",
+		"left_edge", "right_edge", "running_sum", "temperature", "x", "y", "n" };
+	for (unsigned int i = 0; i < 64; i++) {
+		this->identifiers.push_back(string(stems[i % 12]) + "_" + to_string(i));
+	}
+}
+
+unsigned int SourceGenerator::pick(unsigned int count) {
+	return (unsigned int) (this->random() % count);
+}
+
+string SourceGenerator::identifier() {
+	return this->identifiers[this->pick((unsigned int) this->identifiers.size())];
+}
+
+void SourceGenerator::keyword_statement(string& out) {
+	// control flow, so mostly reserved words and short operands
+	switch (this->pick(4)) {
+		case 0:
+			out += "if " + this->identifier() + " < " + this->identifier() + " then begin "
+				+ this->identifier() + " := " + this->identifier() + " div 2 end else begin "
+				+ this->identifier() + " := " + this->identifier() + " mod 3 end;\n";
+			break;
+		case 1:
+			out += "while not (" + this->identifier() + " = 0) and true do begin "
+				+ this->identifier() + " := " + this->identifier() + " - 1 end;\n";
+			break;
+		case 2:
+			out += "repeat " + this->identifier() + " := " + this->identifier()
+				+ " + 1 until " + this->identifier() + " >= 10;\n";
+			break;
+		default:
+			out += "for " + this->identifier() + " := 1 to 10 do begin read("
+				+ this->identifier() + "); writeln(" + this->identifier() + ") end;\n";
+			break;
+	}
+}
+
+void SourceGenerator::identifier_statement(string& out) {
+	// long assignment chains of plain names
+	out += this->identifier() + " := " + this->identifier();
+	unsigned int terms = 2 + this->pick(6);
+	for (unsigned int i = 0; i < terms; i++) {
+		out += (this->pick(2) == 0 ? " + " : " * ") + this->identifier();
+	}
+	out += ";\n";
+}
+
+void SourceGenerator::comment_statement(string& out) {
+	// a comment of a few hundred to a few thousand bytes, over
+	// several lines, ahead of a short statement
+	static const char* words[] = { "the", "scanner", "skips", "this", "text",
+		"between", "two", "braces", "and", "all", "of", "its", "lines" };
+	size_t length = 200 + this->pick(2000);
+	out += "{ ";
+	size_t start = out.size();
+	while (out.size() - start < length) {
+		out += words[this->pick(13)];
+		out += (this->pick(12) == 0) ? "\n  " : " ";
+	}
+	out += "}\n" + this->identifier() + " := 0;\n";
+}
+
+void SourceGenerator::string_statement(string& out) {
+	// a long literal with punctuation in it
+	static const char* words[] = { "hello", "world", "its", "a", "long",
+		"string", "with", "some", "punctuation:", "(1, 2, 3);", "done." };
+	size_t length = 100 + this->pick(1000);
+	out += "writeln('";
+	size_t start = out.size();
+	while (out.size() - start < length) {
+		out += words[this->pick(11)];
+		out += " ";
+	}
+	out += "');\n";
+}
+
+void SourceGenerator::expression(string& out, unsigned int depth) {
+	// a fully parenthesized expression nested depth levels down
+	static const char* operators[] = { " + ", " - ", " * ", " div ", " mod ", " and ", " or " };
+	if (depth == 0) {
+		if (this->pick(2) == 0) {
+			out += this->identifier();
+		} else {
+			out += to_string(this->pick(1000));
+		}
+		return;
+	}
+	out += "(";
+	this->expression(out, depth - 1);
+	out += operators[this->pick(7)];
+	this->expression(out, this->pick(depth));
+	out += ")";
+}
+
+void SourceGenerator::expression_statement(string& out) {
+	out += this->identifier() + " := ";
+	this->expression(out, 8 + this->pick(24));
+	out += ";\n";
+}
+
+string SourceGenerator::generate(size_t size) {
+	// a program of at least size bytes, statements
+	// are added until it is large enough
+	string out = "program benchmark;\nvar ";
+	for (unsigned int i = 0; i < this->identifiers.size(); i++) {
+		out += (i == 0 ? "" : ", ") + this->identifiers[i];
+	}
+	out += " : integer;\nbegin\n";
+	out.reserve(size + 4096);
+	while (out.size() < size) {
+		SourceShape next = this->shape;
+		if (next == MIXED_SHAPES) {
+			next = (SourceShape) this->pick(MIXED_SHAPES);
+		}
+		switch (next) {
+			case KEYWORD_HEAVY:
+				this->keyword_statement(out);
+				break;
+			case IDENTIFIER_HEAVY:
+				this->identifier_statement(out);
+				break;
+			case LONG_COMMENTS:
+				this->comment_statement(out);
+				break;
+			case LONG_STRINGS:
+				this->string_statement(out);
+				break;
+			default:
+				this->expression_statement(out);
+				break;
+		}
+	}
+	out += this->identifier() + " := 0\nend.\n";
+	return out;
+}
+
+bool SourceGenerator::get_shape(string name, SourceShape& shape) {
+	for (unsigned int i = KEYWORD_HEAVY; i <= MIXED_SHAPES; i++) {
+		if (SourceGenerator::get_shape_name((SourceShape) i) == name) {
+			shape = (SourceShape) i;
+			return true;
+		}
+	}
+	return false;
+}
+
+string SourceGenerator::get_shape_name(SourceShape shape) {
+	switch (shape) {
+		case KEYWORD_HEAVY: return "keywords";
+		case IDENTIFIER_HEAVY: return "identifiers";
+		case LONG_COMMENTS: return "comments";
+		case LONG_STRINGS: return "strings";
+		case DEEP_EXPRESSIONS: return "expressions";
+		default: return "mixed";
+	}
+}
+
+ScanBenchmark::ScanBenchmark(SourceShape shape, size_t size, unsigned int seed, unsigned int threads) {
+	this->shape = shape;
+	this->threads = threads;
+	this->source = SourceGenerator(shape, seed).generate(size);
+	this->token_count = 0;
+}
+
+void ScanBenchmark::run(unsigned int runs) {
+	// every run scans a fresh copy of the program, only
+	// the scan itself is timed
+	this->seconds.clear();
+	for (unsigned int i = 0; i < runs; i++) {
+		ScannerPtr scanner = ScannerPtr(new Scanner(Input::open_string(this->source)));
+		scanner->set_scan_threads(this->threads);
+		auto start = chrono::steady_clock::now();
+		scanner->scan_all();
+		auto stop = chrono::steady_clock::now();
+		this->seconds.push_back(chrono::duration<double>(stop - start).count());
+		this->token_count = scanner->get_tokens()->size();
+	}
+}
+
+double ScanBenchmark::percentile(const vector<double>& sorted, double rank) {
+	// nearest rank on an ascending list
+	size_t index = (size_t) ceil(rank / 100.0 * sorted.size());
+	return sorted[(index == 0) ? 0 : index - 1];
+}
+
+void ScanBenchmark::report() {
+	if (this->seconds.empty()) {
+		return;
+	}
+	vector<double> sorted = this->seconds;
+	sort(sorted.begin(), sorted.end());
+	double megabytes = this->source.size() / (1024.0 * 1024.0);
+	report_msg_type("Shape", SourceGenerator::get_shape_name(this->shape));
+	report_msg_type("Source", to_string(this->source.size()) + " bytes, "
+					+ to_string(this->token_count) + " tokens, "
+					+ to_string(sorted.size()) + " runs");
+	report_msg_type("Threads", (this->threads == 0) ? string("every core") : to_string(this->threads));
+	
+	// percentiles of run time, slower runs further down
+	static const double ranks[] = { 0, 50, 90, 99, 100 };
+	static const char* names[] = { "best", "p50", "p90", "p99", "worst" };
+	cout << setw(8) << "" << setw(12) << "ms" << setw(12) << "MB/s" << setw(16) << "tokens/s" << endl;
+	for (unsigned int i = 0; i < 5; i++) {
+		double time = ScanBenchmark::percentile(sorted, ranks[i]);
+		cout << setw(8) << names[i] << fixed << setprecision(2)
+			 << setw(12) << time * 1000.0
+			 << setw(12) << megabytes / time
+			 << setw(16) << setprecision(0) << this->token_count / time << endl;
+	}
+	cout.unsetf(ios::floatfield);
+	cout << setprecision(6);
+}
+
+int scanner_benchmark(string shape_name, size_t size, unsigned int runs, unsigned int threads) {
+	cout << "[ Scanner Benchmark ]" << endl;
+	SourceShape shape;
+	if (!SourceGenerator::get_shape(shape_name, shape) || size == 0 || runs == 0) {
+		report_error("Benchmark Error", "Expected a shape (keywords, identifiers, comments, "
+					 "strings, expressions or mixed), a size in bytes and a run count");
+		return -1;
+	}
+	ScanBenchmark benchmark(shape, size, 1, threads);
+	benchmark.run(runs);
+	benchmark.report();
+	cout << "[ End ]" << endl;
+	return 0;
+}
+
+ParseBenchmark::ParseBenchmark(SourceShape shape, size_t size, unsigned int seed) {
+	this->shape = shape;
+	this->source = SourceGenerator(shape, seed).generate(size);
+}
+
+double ParseBenchmark::parse(ParserVariant variant) {
+	// one parse from a fresh scanner and analyzer, the parser
+	// reports its result on cout so that is muted meanwhile
+	ScannerPtr scanner = ScannerPtr(new Scanner(Input::open_string(this->source)));
+	SemanticAnalyzerPtr analyzer = SemanticAnalyzerPtr(new SemanticAnalyzer("benchmark"));
+	ParserPtr parser = ParserPtr(new Parser(scanner, analyzer));
+	parser->set_table_driven(variant != RECURSIVE_DESCENT);
+	parser->set_pipelined(variant == TABLE_DRIVEN_PIPELINED);
+	streambuf* shown = cout.rdbuf(nullptr);
+	auto start = chrono::steady_clock::now();
+	parser->parse();
+	auto stop = chrono::steady_clock::now();
+	cout.rdbuf(shown);
+	cout.clear();
+	return chrono::duration<double>(stop - start).count();
+}
+
+void ParseBenchmark::run(unsigned int runs) {
+	// the variants take turns so drift in the machine
+	// is spread over all of them
+	this->seconds.assign(TABLE_DRIVEN_PIPELINED + 1, vector<double>());
+	for (unsigned int i = 0; i < runs; i++) {
+		for (unsigned int variant = RECURSIVE_DESCENT; variant <= TABLE_DRIVEN_PIPELINED; variant++) {
+			this->seconds[variant].push_back(this->parse((ParserVariant) variant));
+		}
+	}
+}
+
+string ParseBenchmark::get_variant_name(ParserVariant variant) {
+	switch (variant) {
+		case RECURSIVE_DESCENT: return "recursive";
+		case TABLE_DRIVEN: return "table";
+		default: return "pipelined";
+	}
+}
+
+void ParseBenchmark::report() {
+	if (this->seconds.empty() || this->seconds[0].empty()) {
+		return;
+	}
+	double megabytes = this->source.size() / (1024.0 * 1024.0);
+	report_msg_type("Shape", SourceGenerator::get_shape_name(this->shape));
+	report_msg_type("Source", to_string(this->source.size()) + " bytes, "
+					+ to_string(this->seconds[0].size()) + " runs");
+	
+	// median and tail per variant, and the median against recursive descent
+	vector<double> baseline = this->seconds[RECURSIVE_DESCENT];
+	sort(baseline.begin(), baseline.end());
+	cout << setw(12) << "" << setw(12) << "p50 ms" << setw(12) << "p90 ms"
+		 << setw(12) << "MB/s" << setw(12) << "speedup" << endl;
+	for (unsigned int variant = RECURSIVE_DESCENT; variant <= TABLE_DRIVEN_PIPELINED; variant++) {
+		vector<double> sorted = this->seconds[variant];
+		sort(sorted.begin(), sorted.end());
+		double median = ScanBenchmark::percentile(sorted, 50);
+		cout << setw(12) << ParseBenchmark::get_variant_name((ParserVariant) variant)
+			 << fixed << setprecision(2)
+			 << setw(12) << median * 1000.0
+			 << setw(12) << ScanBenchmark::percentile(sorted, 90) * 1000.0
+			 << setw(12) << megabytes / median
+			 << setw(12) << ScanBenchmark::percentile(baseline, 50) / median << endl;
+	}
+	cout.unsetf(ios::floatfield);
+	cout << setprecision(6);
+}
+
+int parser_benchmark(string shape_name, size_t size, unsigned int runs) {
+	cout << "[ Parser Benchmark ]" << endl;
+	SourceShape shape;
+	if (!SourceGenerator::get_shape(shape_name, shape) || size == 0 || runs == 0) {
+		report_error("Benchmark Error", "Expected a shape (keywords, identifiers, comments, "
+					 "strings, expressions or mixed), a size in bytes and a run count");
+		return -1;
+	}
+	ParseBenchmark benchmark(shape, size, 1);
+	benchmark.run(runs);
+	benchmark.report();
+	cout << "[ End ]" << endl;
+	return 0;
+}
+
+RescanBenchmark::RescanBenchmark(SourceShape shape, size_t size, unsigned int seed) {
+	this->shape = shape;
+	this->seed = seed;
+	this->source = SourceGenerator(shape, seed).generate(size);
+	this->scan_seconds = 0;
+	this->token_count = 0;
+}
+
+void RescanBenchmark::run(unsigned int edits) {
+	// edits take turns putting a space in next to another one and taking
+	// it out again, so the program keeps its size and its tokens. the
+	// same edits are made to a second input to time moving its bytes
+	// without any scanning
+	InputPtr input = Input::open_string(this->source);
+	InputPtr edited = Input::open_string(this->source);
+	ScannerPtr scanner = ScannerPtr(new Scanner(input));
+	auto start = chrono::steady_clock::now();
+	scanner->scan_all();
+	auto stop = chrono::steady_clock::now();
+	this->scan_seconds = chrono::duration<double>(stop - start).count();
+	this->token_count = scanner->get_tokens()->size();
+	this->edit_seconds.clear();
+	this->rescan_seconds.clear();
+	mt19937 random(this->seed);
+	size_t offset = 0;
+	for (unsigned int i = 0; i < edits; i++) {
+		bool insert = i % 2 == 0;
+		if (insert) {
+			offset = random() % this->source.size();
+			while (offset < this->source.size() && this->source[offset] != ' ') {
+				offset++;
+			}
+		}
+		size_t length = insert ? 0 : 1;
+		string replacement = insert ? string(" ") : string();
+		start = chrono::steady_clock::now();
+		edited->replace(offset, length, replacement);
+		stop = chrono::steady_clock::now();
+		this->edit_seconds.push_back(chrono::duration<double>(stop - start).count());
+		start = chrono::steady_clock::now();
+		scanner->rescan(offset, length, replacement);
+		stop = chrono::steady_clock::now();
+		this->rescan_seconds.push_back(chrono::duration<double>(stop - start).count());
+	}
+}
+
+void RescanBenchmark::report() {
+	if (this->rescan_seconds.empty()) {
+		return;
+	}
+	report_msg_type("Shape", SourceGenerator::get_shape_name(this->shape));
+	report_msg_type("Source", to_string(this->source.size()) + " bytes, "
+					+ to_string(this->token_count) + " tokens, "
+					+ to_string(this->rescan_seconds.size()) + " edits");
+	
+	// percentiles of the time per edit, and the full scan it saves
+	vector<double> edit_sorted = this->edit_seconds;
+	vector<double> rescan_sorted = this->rescan_seconds;
+	sort(edit_sorted.begin(), edit_sorted.end());
+	sort(rescan_sorted.begin(), rescan_sorted.end());
+	cout << setw(12) << "" << setw(12) << "p50 us" << setw(12) << "p90 us"
+		 << setw(12) << "worst us" << endl;
+	cout << fixed << setprecision(1);
+	cout << setw(12) << "input" << setw(12) << ScanBenchmark::percentile(edit_sorted, 50) * 1e6
+		 << setw(12) << ScanBenchmark::percentile(edit_sorted, 90) * 1e6
+		 << setw(12) << ScanBenchmark::percentile(edit_sorted, 100) * 1e6 << endl;
+	cout << setw(12) << "rescan" << setw(12) << ScanBenchmark::percentile(rescan_sorted, 50) * 1e6
+		 << setw(12) << ScanBenchmark::percentile(rescan_sorted, 90) * 1e6
+		 << setw(12) << ScanBenchmark::percentile(rescan_sorted, 100) * 1e6 << endl;
+	cout << setw(12) << "full scan" << setw(12) << this->scan_seconds * 1e6 << endl;
+	cout.unsetf(ios::floatfield);
+	cout << setprecision(6);
+}
+
+int rescan_benchmark(string shape_name, size_t size, unsigned int edits) {
+	cout << "[ Rescan Benchmark ]" << endl;
+	SourceShape shape;
+	if (!SourceGenerator::get_shape(shape_name, shape) || size == 0 || edits == 0) {
+		report_error("Benchmark Error", "Expected a shape (keywords, identifiers, comments, "
+					 "strings, expressions or mixed), a size in bytes and an edit count");
+		return -1;
+	}
+	RescanBenchmark benchmark(shape, size, 1);
+	benchmark.run(edits);
+	benchmark.report();
+	cout << "[ End ]" << endl;
+	return 0;
+}
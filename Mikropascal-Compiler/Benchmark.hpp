@@ -0,0 +1,110 @@
+#ifndef benchmark_h
+#define benchmark_h
+
+#include "Standard.hpp"
+#include "Input.hpp"
+#include "Scanner.hpp"
+#include "Parser.hpp"
+#include "Helper.hpp"
+
+// what a generated program is mostly made of
+enum SourceShape {
+	KEYWORD_HEAVY,
+	IDENTIFIER_HEAVY,
+	LONG_COMMENTS,
+	LONG_STRINGS,
+	DEEP_EXPRESSIONS,
+	MIXED_SHAPES
+};
+
+// generates Mikropascal programs of a given size and shape, the same
+// seed always gives the same program so runs can be compared
+class SourceGenerator {
+private:
+	SourceShape shape;
+	mt19937 random;
+	vector<string> identifiers;
+	
+	// pieces of a program
+	unsigned int pick(unsigned int count);
+	string identifier();
+	void keyword_statement(string& out);
+	void identifier_statement(string& out);
+	void comment_statement(string& out);
+	void string_statement(string& out);
+	void expression(string& out, unsigned int depth);
+	void expression_statement(string& out);
+public:
+	SourceGenerator(SourceShape shape, unsigned int seed);
+	virtual ~SourceGenerator() = default;
+	string generate(size_t size);
+	
+	// shapes by their command line names
+	static bool get_shape(string name, SourceShape& shape);
+	static string get_shape_name(SourceShape shape);
+};
+
+// times Scanner::scan_all over a generated program, reporting
+// throughput percentiles across a number of runs
+class ScanBenchmark {
+private:
+	string source;
+	SourceShape shape;
+	vector<double> seconds;
+	size_t token_count;
+	unsigned int threads;
+public:
+	ScanBenchmark(SourceShape shape, size_t size, unsigned int seed, unsigned int threads);
+	virtual ~ScanBenchmark() = default;
+	void run(unsigned int runs);
+	void report();
+	static double percentile(const vector<double>& sorted, double rank);
+};
+
+// the ways the parser can be run
+enum ParserVariant {
+	RECURSIVE_DESCENT,
+	TABLE_DRIVEN,
+	TABLE_DRIVEN_PIPELINED
+};
+
+// times whole parses of a generated program with each parser
+// variant, scanning included, so the variants can be compared
+class ParseBenchmark {
+private:
+	string source;
+	SourceShape shape;
+	vector<vector<double>> seconds;
+	double parse(ParserVariant variant);
+public:
+	ParseBenchmark(SourceShape shape, size_t size, unsigned int seed);
+	virtual ~ParseBenchmark() = default;
+	void run(unsigned int runs);
+	void report();
+	static string get_variant_name(ParserVariant variant);
+};
+
+// times one byte edits at random places in a scanned program,
+// the edit of the input on its own and the whole rescan, against
+// a scan of the program from scratch
+class RescanBenchmark {
+private:
+	string source;
+	SourceShape shape;
+	unsigned int seed;
+	vector<double> edit_seconds;
+	vector<double> rescan_seconds;
+	double scan_seconds;
+	size_t token_count;
+public:
+	RescanBenchmark(SourceShape shape, size_t size, unsigned int seed);
+	virtual ~RescanBenchmark() = default;
+	void run(unsigned int edits);
+	void report();
+};
+
+int scanner_benchmark(string shape_name, size_t size, unsigned int runs, unsigned int threads);
+int parser_benchmark(string shape_name, size_t size, unsigned int runs);
+int rescan_benchmark(string shape_name, size_t size, unsigned int edits);
+
+#endif
@@ -1,5 +1,6 @@
 #include "Standard.hpp"
 #include "Tests.hpp"
+#include "Benchmark.hpp"
 
 string get_console_input() {
 	string input, first;
@@ -58,7 +59,38 @@ void menu_loop() {
 
 int main(int argc, char* argv[]) {
 	report_msg("Mikropascal Compiler");
-	if (argc == 3) {
+	if (argc == 3 && (strcmp(argv[1], "-g") == 0)) {
+		// regenerate the baked scanner tables
+		Scanner::write_tables(string(argv[2]));
+	} else if (argc == 3 && (strcmp(argv[1], "-b") == 0)) {
+		// write the scanner tables as a binary table file
+		Scanner::write_table_file(string(argv[2]));
+	} else if (argc >= 3 && argc <= 6 && (strcmp(argv[1], "-m") == 0)) {
+		// time the scanner on a generated program, 4 MB over 10 runs on one
+		// thread unless given (0 threads scans on every core)
+		scanner_benchmark(string(argv[2]), (argc > 3) ? strtoul(argv[3], NULL, 10) : (4 << 20),
+						  (argc > 4) ? (unsigned int) strtoul(argv[4], NULL, 10) : 10,
+						  (argc > 5) ? (unsigned int) strtoul(argv[5], NULL, 10) : 1);
+	} else if (argc >= 3 && argc <= 5 && (strcmp(argv[1], "-n") == 0)) {
+		// time each parser variant on a generated program, 256 KB over 10 runs unless given
+		parser_benchmark(string(argv[2]), (argc > 3) ? strtoul(argv[3], NULL, 10) : (256 << 10),
+						 (argc > 4) ? (unsigned int) strtoul(argv[4], NULL, 10) : 10);
+	} else if (argc >= 3 && argc <= 5 && (strcmp(argv[1], "-o") == 0)) {
+		// time one byte edits and their rescans on a generated program,
+		// 4 MB with 200 edits unless given
+		rescan_benchmark(string(argv[2]), (argc > 3) ? strtoul(argv[3], NULL, 10) : (4 << 20),
+						 (argc > 4) ? (unsigned int) strtoul(argv[4], NULL, 10) : 200);
+	} else if (argc == 4 && (strcmp(argv[1], "-f") == 0)) {
+		// write a table file, then scan a file with it loaded back in
+		scanner_table_file_test(string(argv[2]), string(argv[3]));
+	} else if ((argc == 5 || argc == 6) && (strcmp(argv[1], "-u") == 0)) {
+		// replace bytes of a scanned file and rescan only around them
+		scanner_rescan_test(string(argv[2]), strtoul(argv[3], NULL, 10), strtoul(argv[4], NULL, 10),
+							(argc > 5) ? string(argv[5]) : string());
+	} else if (argc == 3 && (strcmp(argv[1], "-e") == 0)) {
+		// list the tree the precedence parser builds for an expression
+		expression_test(string(argv[2]));
+	} else if (argc == 3) {
 
 		// try open file
 		FILE* fp = NULL;
@@ -77,6 +109,14 @@ int main(int argc, char* argv[]) {
 				scanner_test(string(argv[2]));
 			} else if (strcmp(argv[1], "-p") == 0) {
 				parser_test(string(argv[2]));
+			} else if (strcmp(argv[1], "-l") == 0) {
+				parser_pipeline_test(string(argv[2]));
+			} else if (strcmp(argv[1], "-t") == 0) {
+				parser_table_test(string(argv[2]));
+			} else if (strcmp(argv[1], "-z") == 0) {
+				flat_tree_test(string(argv[2]));
+			} else if (strcmp(argv[1], "-r") == 0) {
+				parser_trace_test(string(argv[2]));
 			} else if (strcmp(argv[1], "-y") == 0) {
 				symbol_test(string(argv[2]));
 			} else if (strcmp(argv[1], "-c") == 0) {
@@ -89,6 +129,18 @@ int main(int argc, char* argv[]) {
 		}
 	} else if (argc == 2 && (strcmp(argv[1], "-i") == 0)) {
 		menu_loop();
+	} else if (argc == 2 && (strcmp(argv[1], "-q") == 0)) {
+		// list the grammar's predict table
+		grammar_table_test();
+	} else if (argc == 2 && (strcmp(argv[1], "-a") == 0)) {
+		// combine and compile a pair of keyword machines
+		automata_compile_test_cases();
+	} else if (argc == 2 && (strcmp(argv[1], "-x") == 0)) {
+		// build a machine from regular expressions
+		automata_regex_test_cases();
+	} else if (argc == 2 && (strcmp(argv[1], "-k") == 0)) {
+		// check the baked scanner tables are current
+		scanner_tables_test();
 	} else {
 		report_msg_type("Warning", "No cmd line args, specified... going to default folder");
 		FILE* fp = NULL;
@@ -8,6 +8,9 @@
 // class predefs
 class FiniteMachineContainer;
 class FiniteMachineState;
+class CompiledMachine;
+struct MachineTables;
+class RegexBuilder;
 
 // type aliases
 using StatePtr = shared_ptr<FiniteMachineState>;
@@ -20,22 +23,52 @@ using TransitionMapIterator = TransitionMap::iterator;
 using FSMachinePtr = shared_ptr<FiniteMachineContainer>;
 using FSMachineList = vector<FSMachinePtr>;
 using FSMachineListPtr = shared_ptr<FSMachineList>;
+using CompiledMachinePtr = shared_ptr<CompiledMachine>;
+using RegexBuilderPtr = shared_ptr<RegexBuilder>;
+using StateHandle = unsigned int;
 
 // const string reference values
 static const char* dead_state_name = "DEAD";
 
+// the handle of a state that does not exist
+static const StateHandle no_state = UINT_MAX;
+
+// binary format for compiled machines, which external tools can
+// read too. all fields are in the writer's byte order, a reader with
+// the other order sees a wrong byte order mark and rejects the file
+//   0   char[4]   magic "MPDF"
+//   4   uint16    version
+//   6   uint16    byte order mark 0x0102
+//   8   uint32    state count (n)
+//   12  uint32    byte class count (k)
+//   16  uint32    accept name count
+//   20  uint32    reserved, 0
+//   24  uint8     byte classes [256]
+//   280 uint16    transitions [n * k], then zeros up to a multiple of 4
+//       uint32    accept bits [(n + 31) / 32]
+//       uint16    accept tags [n], then zeros up to a multiple of 4
+//       accept names, each a uint32 length then its characters
+static const char* machine_file_magic = "MPDF";
+static const uint16_t machine_file_version = 1;
+static const uint16_t machine_file_byte_order = 0x0102;
+static const size_t machine_file_header_size = 24;
+
 // class that creates a state in an FA
 class FiniteMachineState : public enable_shared_from_this<FiniteMachineState> {
 private:
 	bool is_final_state;
 	bool is_initial_state;
 	string machine_name;
+	string accept_name;
+	StateHandle id;
 	TransitionMapPtr transition_map;
 public:
 	// ctor
 	FiniteMachineState(bool is_initial_state, bool is_final_state, string machine_name) :
 			is_final_state(is_final_state), is_initial_state(is_initial_state), machine_name(machine_name) {
 		this->transition_map = TransitionMapPtr(new TransitionMap);
+		this->accept_name = "";
+		this->id = no_state;
 	}
 	// dtor
 	virtual ~FiniteMachineState() {
@@ -57,6 +90,23 @@ public:
 	void set_name(string name) {
 		this->machine_name = name;
 	}
+	// get the name of the machine this final state accepts for
+	// (only set on states of a combined machine)
+	string get_accept_name() {
+		return this->accept_name;
+	}
+	// set the name of the machine this final state accepts for
+	void set_accept_name(string name) {
+		this->accept_name = name;
+	}
+	// the handle of this state in its machine
+	StateHandle get_id() {
+		return this->id;
+	}
+	// set by the machine when the state is added
+	void set_id(StateHandle id) {
+		this->id = id;
+	}
 	// set initial state
 	void set_is_initial(bool is_initial) {
 		this->is_initial_state = is_initial;
@@ -99,14 +149,473 @@ public:
 	}
 };
 
+// a read-only view of a compiled machine's tables. it may point into
+// a machine, or into arrays baked in at build time, and can be stepped
+// without owning anything
+struct MachineTables {
+	unsigned int num_states;
+	unsigned int num_classes;
+	const uint8_t* byte_classes;
+	const uint16_t* table;
+	const uint32_t* accept_bits;
+	const uint16_t* accept_tags;
+	
+	// the state reached from a state through a character
+	inline uint16_t next(uint16_t state, char c) const {
+		return this->table[state * this->num_classes
+						   + this->byte_classes[(unsigned char) c]];
+	}
+	
+	// determines if a state is final
+	inline bool is_final(uint16_t state) const {
+		return ((this->accept_bits[state >> 5] >> (state & 31)) & 1) != 0;
+	}
+	
+	// reads a machine written by CompiledMachine::write_binary in
+	// place, so the tables point into the data and it has to outlive
+	// them. anything that is not a whole, consistent file of this
+	// version is rejected, since a bad table would step out of bounds
+	static bool read_binary(const char* data, size_t size, MachineTables& tables,
+							vector<string>& accept_names) {
+		if (size < machine_file_header_size || ((uintptr_t) data & 3) != 0
+			|| memcmp(data, machine_file_magic, 4) != 0) {
+			return false;
+		}
+		uint16_t version, byte_order;
+		uint32_t num_states, num_classes, num_names;
+		memcpy(&version, data + 4, sizeof(version));
+		memcpy(&byte_order, data + 6, sizeof(byte_order));
+		memcpy(&num_states, data + 8, sizeof(num_states));
+		memcpy(&num_classes, data + 12, sizeof(num_classes));
+		memcpy(&num_names, data + 16, sizeof(num_names));
+		if (version != machine_file_version || byte_order != machine_file_byte_order
+			|| num_states < 2 || num_states > UINT16_MAX
+			|| num_classes < 1 || num_classes > 256 || num_names < 1) {
+			return false;
+		}
+		
+		// find every array, checking they all fit
+		size_t table_size = (size_t) num_states * num_classes;
+		size_t classes_at = machine_file_header_size;
+		size_t table_at = classes_at + 256;
+		size_t bits_at = (table_at + table_size * sizeof(uint16_t) + 3) & ~(size_t) 3;
+		size_t tags_at = bits_at + ((num_states + 31) / 32) * sizeof(uint32_t);
+		size_t names_at = (tags_at + num_states * sizeof(uint16_t) + 3) & ~(size_t) 3;
+		if (names_at > size) {
+			return false;
+		}
+		tables.num_states = num_states;
+		tables.num_classes = num_classes;
+		tables.byte_classes = (const uint8_t*) (data + classes_at);
+		tables.table = (const uint16_t*) (data + table_at);
+		tables.accept_bits = (const uint32_t*) (data + bits_at);
+		tables.accept_tags = (const uint16_t*) (data + tags_at);
+		
+		// every class, target and tag must be in range
+		for (unsigned int b = 0; b < 256; b++) {
+			if (tables.byte_classes[b] >= num_classes) {
+				return false;
+			}
+		}
+		for (size_t i = 0; i < table_size; i++) {
+			if (tables.table[i] >= num_states) {
+				return false;
+			}
+		}
+		for (size_t i = 0; i < num_states; i++) {
+			if (tables.accept_tags[i] >= num_names) {
+				return false;
+			}
+		}
+		
+		// the names are copied out, they are only looked up once
+		accept_names.clear();
+		size_t offset = names_at;
+		for (uint32_t i = 0; i < num_names; i++) {
+			uint32_t length;
+			if (size - offset < sizeof(length)) {
+				return false;
+			}
+			memcpy(&length, data + offset, sizeof(length));
+			offset += sizeof(length);
+			if (size - offset < length) {
+				return false;
+			}
+			accept_names.push_back(string(data + offset, length));
+			offset += length;
+		}
+		return true;
+	}
+};
+
+// an immutable, table driven form of an FA. states are numbered,
+// with 0 as the dead state and 1 as the initial state, and the
+// transitions live in one flat [state][byte class] table so that a
+// step is a single indexed load
+class CompiledMachine {
+private:
+	// table dimensions
+	unsigned int num_states;
+	unsigned int num_classes;
+	
+	// maps every byte onto a column of the table
+	uint8_t byte_classes[256];
+	
+	// flat transition table, indexed by state * num_classes + class
+	vector<uint16_t> table;
+	
+	// one bit per state, set if the state is final
+	vector<uint32_t> accept_bits;
+	
+	// per state index into the accept names (for combined machines)
+	vector<uint16_t> accept_tags;
+	vector<string> accept_names;
+	
+	// current state while running
+	uint16_t run_state;
+	
+	friend class FiniteMachineContainer;
+	friend class RegexBuilder;
+	
+public:
+	// the dead and initial state ids
+	enum StateId {
+		dead_state = 0,
+		initial_state = 1
+	};
+	
+	// ctor builds an empty table of the given dimensions
+	CompiledMachine(unsigned int num_states, unsigned int num_classes) :
+			num_states(num_states), num_classes(num_classes) {
+		for (unsigned int i = 0; i < 256; i++) {
+			this->byte_classes[i] = (uint8_t) (i % num_classes);
+		}
+		this->table = vector<uint16_t>(num_states * num_classes, (uint16_t) dead_state);
+		this->accept_bits = vector<uint32_t>((num_states + 31) / 32, 0);
+		this->accept_tags = vector<uint16_t>(num_states, 0);
+		this->accept_names.push_back("");
+		this->run_state = initial_state;
+	}
+	
+	// dtor
+	virtual ~CompiledMachine() = default;
+	
+	// table dimensions
+	unsigned int get_state_count() {
+		return this->num_states;
+	}
+	
+	unsigned int get_class_count() {
+		return this->num_classes;
+	}
+	
+	// the state reached from a state through a character
+	inline uint16_t next(uint16_t state, char c) {
+		return this->table[state * this->num_classes
+						   + this->byte_classes[(unsigned char) c]];
+	}
+	
+	// determines if a state is final
+	inline bool is_final(uint16_t state) {
+		return ((this->accept_bits[state >> 5] >> (state & 31)) & 1) != 0;
+	}
+	
+	// name of the machine a final state accepts for
+	string get_accept_name(uint16_t state) {
+		return this->accept_names[this->accept_tags[state]];
+	}
+	
+	// a view of the tables, valid for as long as this machine is
+	MachineTables get_tables() {
+		MachineTables tables = { this->num_states, this->num_classes,
+			this->byte_classes, this->table.data(),
+			this->accept_bits.data(), this->accept_tags.data() };
+		return tables;
+	}
+	
+	// writes the tables out as C++ constexpr arrays, so a machine
+	// can be generated once and compiled into a program. the arrays
+	// are prefixed with the given name, and name_tables views them
+	void write_tables(ostream& out, string name) {
+		auto write_array = [&](string type, string suffix, size_t count,
+							   size_t per_line, function<unsigned long (size_t)> value) {
+			out << "static constexpr " << type << " " << name << "_" << suffix
+				<< "[" << count << "] = {";
+			for (size_t i = 0; i < count; i++) {
+				out << ((i % per_line == 0) ? "\n\t" : " ") << value(i)
+					<< ((i + 1 < count) ? "," : "");
+			}
+			out << "\n};\n\n";
+		};
+		write_array("uint8_t", "byte_classes", 256, 16,
+					[&](size_t i) { return (unsigned long) this->byte_classes[i]; });
+		write_array("uint16_t", "table", this->table.size(), this->num_classes,
+					[&](size_t i) { return (unsigned long) this->table[i]; });
+		write_array("uint32_t", "accept_bits", this->accept_bits.size(), 4,
+					[&](size_t i) { return (unsigned long) this->accept_bits[i]; });
+		write_array("uint16_t", "accept_tags", this->accept_tags.size(), 16,
+					[&](size_t i) { return (unsigned long) this->accept_tags[i]; });
+		out << "static constexpr MachineTables " << name << "_tables = {\n"
+			<< "\t" << this->num_states << ", " << this->num_classes << ",\n"
+			<< "\t" << name << "_byte_classes, " << name << "_table,\n"
+			<< "\t" << name << "_accept_bits, " << name << "_accept_tags\n"
+			<< "};\n";
+	}
+	
+	// writes the tables in the binary format above, for
+	// MachineTables::read_binary to load in place
+	void write_binary(ostream& out) {
+		size_t written = 0;
+		auto put = [&](const void* data, size_t size) {
+			out.write((const char*) data, size);
+			written += size;
+		};
+		auto align = [&]() {
+			static const char zeros[4] = { 0, 0, 0, 0 };
+			put(zeros, (4 - written % 4) % 4);
+		};
+		uint32_t num_states = this->num_states;
+		uint32_t num_classes = this->num_classes;
+		uint32_t num_names = (uint32_t) this->accept_names.size();
+		uint32_t reserved = 0;
+		put(machine_file_magic, 4);
+		put(&machine_file_version, sizeof(machine_file_version));
+		put(&machine_file_byte_order, sizeof(machine_file_byte_order));
+		put(&num_states, sizeof(num_states));
+		put(&num_classes, sizeof(num_classes));
+		put(&num_names, sizeof(num_names));
+		put(&reserved, sizeof(reserved));
+		put(this->byte_classes, 256);
+		put(this->table.data(), this->table.size() * sizeof(uint16_t));
+		align();
+		put(this->accept_bits.data(), this->accept_bits.size() * sizeof(uint32_t));
+		put(this->accept_tags.data(), this->accept_tags.size() * sizeof(uint16_t));
+		align();
+		for (auto name = this->accept_names.begin(); name != this->accept_names.end(); ++name) {
+			uint32_t length = (uint32_t) name->size();
+			put(&length, sizeof(length));
+			put(name->data(), name->size());
+		}
+	}
+	
+	// resets this FA to its initial state
+	void reset() {
+		this->run_state = initial_state;
+	}
+	
+	// steps through this FA one character at a time
+	void step(char input_char) {
+		this->run_state = this->next(this->run_state, input_char);
+	}
+	
+	// runs a string on this FA
+	void run(string input_str) {
+		for (string::iterator i = input_str.begin(); i != input_str.end(); ++i)
+			this->step(*i);
+	}
+	
+	// determines if this FA has accepted
+	bool accepting() {
+		return this->is_final(this->run_state);
+	}
+	
+	// name of the machine the current state accepts for,
+	// or an empty string if the FA is not accepting
+	string accepting_name() {
+		return this->accepting() ? this->get_accept_name(this->run_state) : "";
+	}
+	
+	// is this FA dead?
+	bool dead() {
+		return this->run_state == dead_state;
+	}
+	
+	// is it not dead?
+	bool not_dead() {
+		return this->run_state != dead_state;
+	}
+	
+	// groups bytes that every state treats the same way into one
+	// class, and shrinks the table to one column per class
+	void compute_byte_classes() {
+		map<vector<uint16_t>, unsigned int> columns;
+		vector<unsigned int> representatives;
+		uint8_t new_classes[256];
+		for (unsigned int b = 0; b < 256; b++) {
+			// the column of targets this byte leads to
+			vector<uint16_t> column(this->num_states);
+			for (unsigned int s = 0; s < this->num_states; s++) {
+				column[s] = this->table[s * this->num_classes + this->byte_classes[b]];
+			}
+			auto found = columns.find(column);
+			if (found == columns.end()) {
+				found = columns.insert(pair<vector<uint16_t>, unsigned int>(
+					column, (unsigned int) representatives.size())).first;
+				representatives.push_back(this->byte_classes[b]);
+			}
+			new_classes[b] = (uint8_t) found->second;
+		}
+		// copy one column per class into the smaller table
+		unsigned int new_count = (unsigned int) representatives.size();
+		vector<uint16_t> new_table(this->num_states * new_count);
+		for (unsigned int s = 0; s < this->num_states; s++) {
+			for (unsigned int c = 0; c < new_count; c++) {
+				new_table[s * new_count + c] =
+					this->table[s * this->num_classes + representatives[c]];
+			}
+		}
+		for (unsigned int b = 0; b < 256; b++) {
+			this->byte_classes[b] = new_classes[b];
+		}
+		this->table.swap(new_table);
+		this->num_classes = new_count;
+	}
+	
+	// merges states that no input can tell apart (hopcroft's
+	// partition refinement), the dead state stays 0 and the
+	// initial state stays 1
+	void minimize() {
+		unsigned int n = this->num_states;
+		unsigned int k = this->num_classes;
+		
+		// states leading into each state, per byte class
+		vector<vector<vector<uint16_t>>> inverse(k, vector<vector<uint16_t>>(n));
+		for (unsigned int s = 0; s < n; s++) {
+			for (unsigned int c = 0; c < k; c++) {
+				inverse[c][this->table[s * k + c]].push_back((uint16_t) s);
+			}
+		}
+		
+		// start from blocks of states that accept the same way
+		vector<unsigned int> block_of(n);
+		vector<vector<uint16_t>> blocks;
+		map<unsigned int, unsigned int> by_accept;
+		for (unsigned int s = 0; s < n; s++) {
+			unsigned int key = this->is_final((uint16_t) s) ? this->accept_tags[s] + 1u : 0u;
+			auto found = by_accept.find(key);
+			if (found == by_accept.end()) {
+				found = by_accept.insert(pair<unsigned int, unsigned int>(
+					key, (unsigned int) blocks.size())).first;
+				blocks.push_back(vector<uint16_t>());
+			}
+			block_of[s] = found->second;
+			blocks[found->second].push_back((uint16_t) s);
+		}
+		
+		// refine until no block splits another
+		vector<unsigned int> work;
+		vector<bool> in_work(blocks.size(), true);
+		for (unsigned int b = 0; b < blocks.size(); b++) {
+			work.push_back(b);
+		}
+		vector<unsigned int> hits(n, 0);
+		vector<bool> marked(n, false);
+		while (!work.empty()) {
+			unsigned int splitter = work.back();
+			work.pop_back();
+			in_work[splitter] = false;
+			vector<uint16_t> splitter_states = blocks[splitter];
+			for (unsigned int c = 0; c < k; c++) {
+				// states stepping into the splitter on this class
+				vector<uint16_t> into;
+				vector<unsigned int> touched;
+				for (auto q = splitter_states.begin(); q != splitter_states.end(); ++q) {
+					for (auto p = inverse[c][*q].begin(); p != inverse[c][*q].end(); ++p) {
+						if (!marked[*p]) {
+							marked[*p] = true;
+							into.push_back(*p);
+							if (hits[block_of[*p]]++ == 0) {
+								touched.push_back(block_of[*p]);
+							}
+						}
+					}
+				}
+				// split every block only partly stepping into it
+				for (auto y = touched.begin(); y != touched.end(); ++y) {
+					if (hits[*y] < blocks[*y].size()) {
+						vector<uint16_t> inside, outside;
+						for (auto q = blocks[*y].begin(); q != blocks[*y].end(); ++q) {
+							(marked[*q] ? inside : outside).push_back(*q);
+						}
+						unsigned int split = (unsigned int) blocks.size();
+						blocks[*y] = outside;
+						blocks.push_back(inside);
+						in_work.push_back(false);
+						for (auto q = inside.begin(); q != inside.end(); ++q) {
+							block_of[*q] = split;
+						}
+						// a block already waiting is split in both halves,
+						// otherwise the smaller half is enough
+						if (in_work[*y]) {
+							work.push_back(split);
+							in_work[split] = true;
+						} else {
+							unsigned int smaller = inside.size() < outside.size() ? split : *y;
+							work.push_back(smaller);
+							in_work[smaller] = true;
+						}
+					}
+					hits[*y] = 0;
+				}
+				for (auto p = into.begin(); p != into.end(); ++p) {
+					marked[*p] = false;
+				}
+			}
+		}
+		
+		// a machine that accepts nothing is already minimal
+		if (block_of[dead_state] == block_of[initial_state]) {
+			return;
+		}
+		
+		// number the blocks, dead and initial first, then in
+		// the order of their lowest state
+		vector<int> new_id(blocks.size(), -1);
+		new_id[block_of[dead_state]] = dead_state;
+		new_id[block_of[initial_state]] = initial_state;
+		vector<uint16_t> representatives = { dead_state, initial_state };
+		for (unsigned int s = 0; s < n; s++) {
+			if (new_id[block_of[s]] == -1) {
+				new_id[block_of[s]] = (int) representatives.size();
+				representatives.push_back((uint16_t) s);
+			}
+		}
+		
+		// rebuild the table over the merged states
+		unsigned int new_count = (unsigned int) representatives.size();
+		vector<uint16_t> new_table(new_count * k);
+		vector<uint32_t> new_bits((new_count + 31) / 32, 0);
+		vector<uint16_t> new_tags(new_count, 0);
+		for (unsigned int s = 0; s < new_count; s++) {
+			uint16_t old = representatives[s];
+			for (unsigned int c = 0; c < k; c++) {
+				new_table[s * k + c] = (uint16_t) new_id[block_of[this->table[old * k + c]]];
+			}
+			if (this->is_final(old)) {
+				new_bits[s >> 5] |= (1u << (s & 31));
+			}
+			new_tags[s] = this->accept_tags[old];
+		}
+		this->table.swap(new_table);
+		this->accept_bits.swap(new_bits);
+		this->accept_tags.swap(new_tags);
+		this->num_states = new_count;
+	}
+};
+
 // class that creates a container in an FA
 class FiniteMachineContainer : public enable_shared_from_this<FiniteMachineContainer> {
 private:
-	// consists of a vector of states, and an iterator over that
-	// vector for running the machine
+	// consists of a vector of states, indexed by state id, and
+	// a pointer into that vector for running the machine
 	StateListPtr state_list;
 	StatePtr run_pointer;
 	StatePtr dead_state;
+	StateHandle initial_id;
+
+	// state names to ids, only for the string based calls
+	// that tests and debugging use
+	unordered_map<string, StateHandle> state_ids;
 	
 	// info variables like a machine name
 	// and if a dead state exists
@@ -124,10 +633,24 @@ private:
 		return this->state_list->end();
 	}
 
+	// appends a state, giving it the next id
+	StateHandle push_state(StatePtr new_state) {
+		StateHandle id = (StateHandle) this->state_list->size();
+		new_state->set_id(id);
+		this->state_list->push_back(new_state);
+		this->state_ids[new_state->get_name()] = id;
+		return id;
+	}
+
+	// is this a state of this machine?
+	bool valid_state(StateHandle id) {
+		return id < this->state_list->size();
+	}
+
 public:
 	// construct an entire finite automata (ctor)
 	FiniteMachineContainer(string name) :
-			dead_state_exists(true), machine_name(name) {
+			initial_id(no_state), dead_state_exists(true), machine_name(name) {
 		
 		// create a list of states
 		this->state_list = StateListPtr(new StateList);
@@ -144,7 +667,7 @@ public:
 	// construct an FA with the option of setting if a dead state exists
 	// performs the same function as the ctor above
 	FiniteMachineContainer(string name, bool dead_states_enabled) :
-			dead_state_exists(dead_states_enabled), machine_name(name) {
+			initial_id(no_state), dead_state_exists(dead_states_enabled), machine_name(name) {
 		this->state_list = StateListPtr(new StateList);
 		this->dead_state = StatePtr(new FiniteMachineState(false, false, "DEAD"));
 		this->run_pointer = StatePtr(this->dead_state);
@@ -176,91 +699,88 @@ public:
 		this->machine_priority = new_priority;
 	}
 
-	// add a state to this automata
-	void add_state(string state_name, bool is_initial, bool is_final) {
-		try {
-			// ensure that the state we're adding is not a copy of a previous one
-			StatePtr old_state = this->get_state(state_name);
-			
-			// error throws a copy state and exits
-			if (old_state != nullptr) {
-				throw string("DFA contains a state that is a copy of another state");
-			} else {
-				// otherwise add this as a state
-				this->state_list->push_back(StatePtr(new FiniteMachineState(is_initial, is_final, state_name)));
+	// number of states, ids run from 0 up to this
+	unsigned int get_state_count() {
+		return (unsigned int) this->state_list->size();
+	}
 
-				// get a state iterator to this new state, so we can edit it a little
-				StatePtr new_state_iter = this->get_state(state_name);
+	// add a state to this automata, named by its id
+	StateHandle add_state(bool is_initial, bool is_final) {
+		return this->add_state(to_string(this->state_list->size()), is_initial, is_final);
+	}
 
-				// set new initial and final states if this node has
-				// been constructed as initial/final
-				if (new_state_iter->get_is_initial() == true) {
-					this->set_initial_state(new_state_iter->get_name());
-				}
-				if (new_state_iter->get_is_final() == true) {
-					this->set_final_state(new_state_iter->get_name(), true);
-				}
-			}
-			// reset the run pointer to a new initial state if necessary
-			this->reset();
-		} catch (string& exception) {
-			return;
+	// add a named state to this automata, returning its id, or
+	// no_state if the name is taken
+	StateHandle add_state(string state_name, bool is_initial, bool is_final) {
+		// ensure that the state we're adding is not a copy of a previous one
+		if (this->state_ids.find(state_name) != this->state_ids.end()) {
+			return no_state;
 		}
+		StateHandle id = this->push_state(StatePtr(new FiniteMachineState(false, is_final, state_name)));
+		
+		// set a new initial state if this node has
+		// been constructed as initial
+		if (is_initial) {
+			this->set_initial_state(id);
+		}
+		// reset the run pointer to a new initial state if necessary
+		this->reset();
+		return id;
 	}
 
-	// remove a state
-	void remove_state(string state_name) {
-		try {
-			// get an iterator to a null state (meaning we need to search for the correct one)
-			StateListIterator rem_target = state_list->end();
-			// get the exact item for removal
-			for (StateListIterator i = this->get_begin_iter();
-					i != this->get_end_iter(); ++i)
-				// we need to find an item with the same state name, which is the correct
-				if ((*i)->get_name().compare(state_name) == 0) {
-					// iterator now set to remove i
-					rem_target = i;
-					break;
-				}
-			// if state found is null
-			if (rem_target == state_list->end()) {
-				throw string("Target state does not exist, cannot remove");
-			}
-
-			// otherwise, remove all invalid transitions to the state we took away
-			// look through each state's transition map to find the appropriate matches
-			for (StateListIterator i = this->get_begin_iter(); i != this->get_end_iter(); ++i) {
-				// iterate through the map
-				for (TransitionMapIterator t = (*i)->get_transitions()->begin();
-					t != (*i)->get_transitions()->end(); ++t) {
+	// remove a state, every state after it moves down one id
+	void remove_state(StateHandle id) {
+		if (!this->valid_state(id)) {
+			return;
+		}
+		StatePtr target = (*this->state_list)[id];
 
-					// if the removal iterator rem_target is equivalent to any iterator
-					// that points to itself
-					if ((*i)->get_name().compare(t->second->get_name()) == 0) {
-						// erase the transition that is pointed to by the map iterator
-						(*i)->get_transitions()->erase(t);
-					}
+		// remove all transitions to the state we took away
+		for (StateListIterator i = this->get_begin_iter(); i != this->get_end_iter(); ++i) {
+			TransitionMapPtr transitions = (*i)->get_transitions();
+			for (TransitionMapIterator t = transitions->begin(); t != transitions->end();) {
+				if (t->second == target) {
+					t = transitions->erase(t);
+				} else {
+					++t;
 				}
 			}
-			// finally, erase the state when all transitions are dealt with
-			this->state_list->erase(rem_target);
-		} catch (string &exception) {
-			// fall through, can't remove a state that's not there
-			return;
 		}
+
+		// finally, erase the state and renumber the ones after it
+		this->state_list->erase(this->state_list->begin() + id);
+		this->state_ids.erase(target->get_name());
+		for (StateHandle i = id; i < this->state_list->size(); i++) {
+			(*this->state_list)[i]->set_id(i);
+			this->state_ids[(*this->state_list)[i]->get_name()] = i;
+		}
+		if (this->initial_id == id) {
+			this->initial_id = no_state;
+		} else if (this->initial_id != no_state && this->initial_id > id) {
+			this->initial_id--;
+		}
+		this->reset();
+	}
+
+	// remove a state by name
+	void remove_state(string state_name) {
+		this->remove_state(this->get_state_id(state_name));
 	}
 
 	// get a state
+	StatePtr get_state(StateHandle id) {
+		return this->valid_state(id) ? (*this->state_list)[id] : nullptr;
+	}
+
+	// get a state by name
 	StatePtr get_state(string state_name) {
-		for (StateListIterator i = this->get_begin_iter();
-				i != this->get_end_iter(); ++i) {
-			// compare names of states to determine if we can obtain
-			if ((*i)->get_name().compare(state_name) == 0) {
-				return StatePtr(*i);
-			}
-		}
-		// otherwise, return null state
-		return nullptr;
+		return this->get_state(this->get_state_id(state_name));
+	}
+
+	// the id of a named state, or no_state
+	StateHandle get_state_id(string state_name) {
+		auto found = this->state_ids.find(state_name);
+		return (found != this->state_ids.end()) ? found->second : no_state;
 	}
 
 	// return all states that are not equivalent to the one given
@@ -285,37 +805,39 @@ public:
 		return StateListPtr(opposite_states);
 	}
 
-	// set a new initial state
-	void set_initial_state(string state_name) {
-		// set initial
-		StatePtr new_initial = this->get_state(state_name);
-		new_initial->set_is_initial(true);
-		StateListPtr new_non_initial = this->get_states_not(state_name);
-
-		// if the first element isn't invalid
-		if (new_non_initial != nullptr) {
-			// set all others to false as initial
-			for (StateListIterator i = new_non_initial->begin();
-					i != new_non_initial->end(); ++i) {
-				(*i)->set_is_initial(false);
-			}
+	// set a new initial state, the old one stops being initial
+	void set_initial_state(StateHandle id) {
+		if (!this->valid_state(id)) {
+			return;
 		}
+		if (this->initial_id != no_state) {
+			(*this->state_list)[this->initial_id]->set_is_initial(false);
+		}
+		this->initial_id = id;
+		(*this->state_list)[id]->set_is_initial(true);
 
 		// move the run iterator to the new starting position
-		this->run_pointer.swap(StatePtr(new_initial));
+		this->run_pointer = (*this->state_list)[id];
 	}
 
-	// sets the final state of this machine
-	void set_final_state(string state_name, bool is_final) {
-		// get the state with the associated name
-		StatePtr new_final = this->get_state(state_name);
+	// set a new initial state by name
+	void set_initial_state(string state_name) {
+		this->set_initial_state(this->get_state_id(state_name));
+	}
 
+	// sets the final state of this machine
+	void set_final_state(StateHandle id, bool is_final) {
 		// if the state selected is valid, add a new finals state
-		if (new_final != nullptr) {
-			new_final->set_is_final(is_final);
+		if (this->valid_state(id)) {
+			(*this->state_list)[id]->set_is_final(is_final);
 		}
 	}
 
+	// sets the final state of this machine by name
+	void set_final_state(string state_name, bool is_final) {
+		this->set_final_state(this->get_state_id(state_name), is_final);
+	}
+
 	// iterate through states to find a final state
 	StateListPtr get_final_states() {
 		StateListPtr final_states = StateListPtr(new StateList);
@@ -327,14 +849,9 @@ public:
 		return final_states;
 	}
 
-	// iterate through states to find an initial state
+	// the initial state, if there is one
 	StatePtr get_initial_state() {
-		for (StateListIterator i = this->get_begin_iter();
-				i != this->get_end_iter(); ++i) {
-			if ((*i)->get_is_initial() == true)
-				return StatePtr(*i);
-		}
-		return nullptr;
+		return this->get_state(this->initial_id);
 	}
 
 	// iterate through states to find the dead state (there should only be one)
@@ -343,76 +860,74 @@ public:
 		return StatePtr(this->dead_state);
 	}
 
-	// add a transition from one state to another
-	void add_transition(string first_state, char through, string second_state) {
-		// get iterators pointing to both new states
-		StatePtr first_state_iter = this->get_state(first_state);
-		StatePtr second_state_iter = this->get_state(second_state);
-		
-		// check to see if both valid
-		if (first_state_iter != nullptr && second_state_iter != nullptr) {
-
-			// check to see if there is already a transition through that same character
-			if (!first_state_iter->transition_exists(through)) {
-				first_state_iter->add_transition(through, second_state_iter);
+	// add a transition from one state to another, unless
+	// the first state already has one through that character
+	void add_transition(StateHandle first_state, char through, StateHandle second_state) {
+		if (this->valid_state(first_state) && this->valid_state(second_state)) {
+			StatePtr first_state_ptr = (*this->state_list)[first_state];
+			if (!first_state_ptr->transition_exists(through)) {
+				first_state_ptr->add_transition(through, (*this->state_list)[second_state]);
 			}
 		}
 	}
 
+	// add a transition between named states
+	void add_transition(string first_state, char through, string second_state) {
+		this->add_transition(this->get_state_id(first_state), through,
+							 this->get_state_id(second_state));
+	}
+
 	// remove a transition
+	void remove_transition(StateHandle first_state, char through) {
+		if (this->valid_state(first_state)) {
+			(*this->state_list)[first_state]->remove_transition(through);
+		}
+	}
+
+	// remove a transition from a named state
 	void remove_transition(string first_state, char through) {
+		this->remove_transition(this->get_state_id(first_state), through);
+	}
 		
-		// get state
-		StatePtr first_state_iter = this->get_state(first_state);
-		
-		// if valid
-		if (first_state_iter != nullptr) {
-
-			// check to see if the through state is in the map
-			if (first_state_iter->transition_exists(through)) {
-				first_state_iter->remove_transition(through);
-			}
+	// add all characters in a range as transitions between two states
+	void add_range(StateHandle first_state, char first, char last, StateHandle second_state) {
+		for (int i = first; i <= last; i++) {
+			this->add_transition(first_state, (char) i, second_state);
 		}
 	}
 
 	// add all alphabetic characters as transitions between these two states
-	void add_alphabet(string first_state, string second_state) {
+	void add_alphabet(StateHandle first_state, StateHandle second_state) {
 		// assumes ascii is used!!!!
-		StatePtr first_state_iter = this->get_state(first_state);
-		StatePtr second_state_iter = this->get_state(second_state);
-		if (first_state_iter != nullptr && second_state_iter != nullptr) {
-			for (int i = 65; i <= 90; i++)
-				this->add_transition(first_state, (char) i, second_state);
-			for (int i = 97; i <= 122; i++)
-				this->add_transition(first_state, (char) i, second_state);
-		}
+		this->add_range(first_state, 'A', 'Z', second_state);
+		this->add_range(first_state, 'a', 'z', second_state);
+	}
+
+	void add_alphabet(string first_state, string second_state) {
+		this->add_alphabet(this->get_state_id(first_state), this->get_state_id(second_state));
 	}
 
 	// add all digits as transitions between two states
+	void add_digits(StateHandle first_state, StateHandle second_state) {
+		// assumes ascii
+		this->add_range(first_state, '0', '9', second_state);
+	}
+
 	void add_digits(string first_state, string second_state) {
+		this->add_digits(this->get_state_id(first_state), this->get_state_id(second_state));
+	}
+
+	// add all printable symbols as transitions between two states
+	void add_symbols(StateHandle first_state, StateHandle second_state) {
 		// assumes ascii
-		StatePtr first_state_iter = this->get_state(first_state);
-		StatePtr second_state_iter = this->get_state(second_state);
-		if (first_state_iter != nullptr && second_state_iter != nullptr) {
-			for (int i = 48; i <= 57; i++)
-				this->add_transition(first_state, (char) i, second_state);
-		}
+		this->add_range(first_state, '!', '/', second_state);
+		this->add_range(first_state, ':', '@', second_state);
+		this->add_range(first_state, '[', '`', second_state);
+		this->add_range(first_state, '{', '~', second_state);
 	}
 	
 	void add_symbols(string first_state, string second_state) {
-		// assumes ascii
-		StatePtr first_state_iter = this->get_state(first_state);
-		StatePtr second_state_iter = this->get_state(second_state);
-		if (first_state_iter != nullptr && second_state_iter != nullptr) {
-			for (int i = 33; i <= 47; i++)
-				this->add_transition(first_state, (char) i, second_state);
-			for (int i = 58; i <= 64; i++)
-				this->add_transition(first_state, (char) i, second_state);
-			for (int i = 91; i <= 96; i++)
-				this->add_transition(first_state, (char) i, second_state);
-			for (int i = 123; i <= 126; i++)
-				this->add_transition(first_state, (char) i, second_state);
-		}
+		this->add_symbols(this->get_state_id(first_state), this->get_state_id(second_state));
 	}
 
 	// give a detailed description of this FA
@@ -464,6 +979,16 @@ public:
 				this->step(*i);
 	}
 	
+	// name of the machine the current state accepts for,
+	// or an empty string if the FA is not accepting
+	string accepting_name() {
+		if (this->accepting()) {
+			return this->run_pointer->get_accept_name();
+		} else {
+			return "";
+		}
+	}
+
 	// is this FA dead?
 	bool dead() {
 		return (this->run_pointer == this->get_dead_state()) ? true : false;
@@ -511,33 +1036,551 @@ public:
 	
 	// builds an FA in this container from a keyword
 	void build_keyword(string keyword) {
-		// build single stage dfas for keywords
+		// build single stage dfas for keywords, one state per
+		// character plus the final state, named by their ids
 		// only run on a newly formed automata
-		int state_counter = 0;
-		string prev_state;
-		string next_state;
-		
-		// create states with zero based names and Q
+		StateHandle prev_state = this->add_state(true, keyword.empty());
 		for (unsigned int i = 0; i < keyword.size(); i++) {
-			if (i == 0)
-				this->add_state(to_string(i), true, false);
-			else
-				this->add_state(to_string(i), false, false);
+			StateHandle next_state = this->add_state(false, i + 1 == keyword.size());
+			pair<char, char> char_pair = all_char_variants(keyword[i]);
+			this->add_transition(prev_state, char_pair.first, next_state);
+			this->add_transition(prev_state, char_pair.second, next_state);
+			prev_state = next_state;
+		}
+	}
+
+	// compiles this FA into a dense transition table. every byte
+	// value gets its own column, and missing transitions go to the
+	// dead state (or loop back, when dead states are disabled)
+	CompiledMachinePtr compile() {
+		// number the states: dead is 0, the initial state is 1
+		StatePtr initial = this->get_initial_state();
+		StateList ordered;
+		if (initial != nullptr) {
+			ordered.push_back(initial);
+		}
+		for (StateListIterator i = this->get_begin_iter(); i != this->get_end_iter(); ++i) {
+			if (*i != initial) {
+				ordered.push_back(*i);
+			}
+		}
+		if (ordered.size() + 1 > UINT16_MAX) {
+			throw string("FA has too many states to compile");
+		}
+		vector<uint16_t> ids(ordered.size());
+		for (unsigned int i = 0; i < ordered.size(); i++) {
+			ids[ordered[i]->get_id()] = (uint16_t) (i + 1);
+		}
+		
+		// fill in the table, one row per state
+		CompiledMachinePtr compiled = CompiledMachinePtr(
+			new CompiledMachine((unsigned int) ordered.size() + 1, 256));
+		map<string, uint16_t> tags;
+		for (unsigned int i = 0; i < ordered.size(); i++) {
+			uint16_t id = (uint16_t) (i + 1);
+			uint16_t* row = &compiled->table[id * compiled->num_classes];
+			if (!this->dead_state_exists) {
+				for (unsigned int c = 0; c < compiled->num_classes; c++) {
+					row[c] = id;
+				}
+			}
+			TransitionMapPtr transitions = ordered[i]->get_transitions();
+			for (TransitionMapIterator t = transitions->begin(); t != transitions->end(); ++t) {
+				// a transition out of this machine goes to the dead state
+				StateHandle target = t->second->get_id();
+				row[(unsigned char) t->first] = (this->get_state(target) == t->second)
+					? ids[target] : (uint16_t) CompiledMachine::dead_state;
+			}
+			
+			// final states and their accept names
+			if (ordered[i]->get_is_final()) {
+				compiled->accept_bits[id >> 5] |= (1u << (id & 31));
+				string accept_name = ordered[i]->get_accept_name();
+				if (accept_name.compare("") != 0) {
+					if (tags.find(accept_name) == tags.end()) {
+						tags[accept_name] = (uint16_t) compiled->accept_names.size();
+						compiled->accept_names.push_back(accept_name);
+					}
+					compiled->accept_tags[id] = tags[accept_name];
+				}
+			}
+		}
+		
+		// shrink the table: bytes to classes, then merge equivalent
+		// states, then classes again since merged states may make
+		// more columns equal
+		compiled->compute_byte_classes();
+		compiled->minimize();
+		compiled->compute_byte_classes();
+		return compiled;
+	}
+
+	// combines a list of machines into one DFA that runs all of them
+	// in lockstep (product construction). each combined state stands for
+	// the tuple of states the machines would be in, so stepping it once
+	// is the same as stepping every machine once. final states are tagged
+	// with the name of the accepting machine of highest priority (lowest
+	// priority value, earliest in the list on ties).
+	static FSMachinePtr combine(string name, FSMachineListPtr machines) {
+		FSMachinePtr combined = FSMachinePtr(new FiniteMachineContainer(name, true));
+		
+		// a tuple holds one state per machine, nullptr for a dead machine
+		using StateTuple = vector<FiniteMachineState*>;
+		map<StateTuple, StatePtr> seen;
+		vector<pair<StateTuple, StatePtr>> work;
+		unsigned int state_counter = 0;
+		
+		// creates (or finds) the combined state for a tuple
+		auto get_combined = [&](const StateTuple& tuple) -> StatePtr {
+			auto found = seen.find(tuple);
+			if (found != seen.end()) {
+				return found->second;
+			}
+			// find the highest priority machine accepting here
+			int winner = -1;
+			for (unsigned int i = 0; i < tuple.size(); i++) {
+				if (tuple[i] != nullptr && tuple[i]->get_is_final()) {
+					if (winner == -1 || (*machines)[i]->get_priority()
+						< (*machines)[winner]->get_priority()) {
+						winner = i;
+					}
+				}
+			}
+			StatePtr new_state = StatePtr(new FiniteMachineState(
+				false, winner != -1, to_string(state_counter)));
+			if (winner != -1) {
+				new_state->set_accept_name((*machines)[winner]->get_name());
+			}
 			state_counter++;
+			combined->push_state(new_state);
+			seen.insert(pair<StateTuple, StatePtr>(tuple, new_state));
+			work.push_back(pair<StateTuple, StatePtr>(tuple, new_state));
+			return new_state;
+		};
+		
+		// the start tuple is every machine in its initial state
+		StateTuple start;
+		for (auto i = machines->begin(); i != machines->end(); i++) {
+			start.push_back((*i)->get_initial_state().get());
+		}
+		combined->set_initial_state(get_combined(start)->get_id());
+		
+		// explore every reachable tuple over all byte values
+		while (!work.empty()) {
+			pair<StateTuple, StatePtr> current = work.back();
+			work.pop_back();
+			for (int c = CHAR_MIN; c <= CHAR_MAX; c++) {
+				StateTuple next(current.first.size(), nullptr);
+				bool alive = false;
+				for (unsigned int i = 0; i < current.first.size(); i++) {
+					FiniteMachineState* state = current.first[i];
+					if (state != nullptr && state->transition_exists((char) c)) {
+						next[i] = state->get_transition((char) c).get();
+						alive = true;
+					}
+				}
+				// no transition means the combined machine dies
+				if (alive) {
+					current.second->add_transition((char) c, get_combined(next));
+				}
+			}
 		}
 		
-		// add final state
-		this->add_state(to_string(state_counter), false, true);
+		// put the run pointer on the start state
+		combined->reset();
+		return combined;
+	}
+};
 
-		// add transitions
-		for (unsigned int i = 0; i < keyword.size(); i++) {
-			pair<char, char> char_pair = all_char_variants(
-					keyword[i]);
-			this->add_transition(to_string(i), char_pair.first,
-					to_string(i + 1));
-			this->add_transition(to_string(i), char_pair.second,
-					to_string(i + 1));
+// builds a compiled machine straight from regular expressions, one
+// per token. every pattern becomes a thompson NFA, the NFAs share one
+// start state, and subset construction turns the union into a DFA
+// whose final states carry the name of the winning pattern (lowest
+// priority value, earliest added on ties). patterns may use literals,
+// escapes (\t \n \v \f \r \xHH, or a backslash before any other
+// character for the character itself), classes ([a-z], [^'] with
+// ranges and escapes inside), '.' for any byte but a newline,
+// grouping, alternation and the * + ? operators.
+class RegexBuilder {
+private:
+	// an NFA state has at most one edge on a set of bytes, and
+	// any number of empty edges
+	struct NfaState {
+		bitset<256> bytes;
+		int target;
+		vector<int> empty;
+		int accepts;
+		NfaState() : target(-1), accepts(-1) {}
+	};
+	
+	// a piece of NFA entered at start and left at end
+	struct Fragment {
+		int start;
+		int end;
+	};
+	
+	// a token's pattern
+	struct Pattern {
+		string name;
+		string pattern;
+		unsigned int priority;
+	};
+	
+	vector<Pattern> patterns;
+	vector<NfaState> nfa;
+	
+	// the pattern being parsed
+	string text;
+	size_t position;
+	
+	int new_state() {
+		this->nfa.push_back(NfaState());
+		return (int) this->nfa.size() - 1;
+	}
+	
+	bool at_end() {
+		return this->position >= this->text.size();
+	}
+	
+	void fail(string message) {
+		throw string("Bad pattern '" + this->text + "': " + message
+					 + " at " + to_string(this->position));
+	}
+	
+	// a fragment stepping over one byte of a set
+	Fragment byte_fragment(const bitset<256>& bytes) {
+		int start = this->new_state();
+		int end = this->new_state();
+		this->nfa[start].bytes = bytes;
+		this->nfa[start].target = end;
+		return Fragment { start, end };
+	}
+	
+	// a fragment matching the empty string
+	Fragment empty_fragment() {
+		int start = this->new_state();
+		int end = this->new_state();
+		this->nfa[start].empty.push_back(end);
+		return Fragment { start, end };
+	}
+	
+	// alternation := concatenation ('|' concatenation)*
+	Fragment parse_alternation() {
+		Fragment left = this->parse_concatenation();
+		while (!this->at_end() && this->text[this->position] == '|') {
+			this->position++;
+			Fragment right = this->parse_concatenation();
+			int start = this->new_state();
+			int end = this->new_state();
+			this->nfa[start].empty.push_back(left.start);
+			this->nfa[start].empty.push_back(right.start);
+			this->nfa[left.end].empty.push_back(end);
+			this->nfa[right.end].empty.push_back(end);
+			left = Fragment { start, end };
+		}
+		return left;
+	}
+	
+	// concatenation := repetition*
+	Fragment parse_concatenation() {
+		Fragment result = { -1, -1 };
+		while (!this->at_end() && this->text[this->position] != '|'
+			   && this->text[this->position] != ')') {
+			Fragment next = this->parse_repetition();
+			if (result.start == -1) {
+				result = next;
+			} else {
+				this->nfa[result.end].empty.push_back(next.start);
+				result.end = next.end;
+			}
 		}
+		return (result.start == -1) ? this->empty_fragment() : result;
+	}
+	
+	// repetition := atom ('*' | '+' | '?')*
+	Fragment parse_repetition() {
+		Fragment atom = this->parse_atom();
+		while (!this->at_end()) {
+			char op = this->text[this->position];
+			if (op != '*' && op != '+' && op != '?') {
+				break;
+			}
+			this->position++;
+			int start = this->new_state();
+			int end = this->new_state();
+			this->nfa[start].empty.push_back(atom.start);
+			this->nfa[atom.end].empty.push_back(end);
+			// * and ? may skip the atom, * and + may repeat it
+			if (op != '+') {
+				this->nfa[start].empty.push_back(end);
+			}
+			if (op != '?') {
+				this->nfa[atom.end].empty.push_back(atom.start);
+			}
+			atom = Fragment { start, end };
+		}
+		return atom;
+	}
+	
+	// atom := '(' alternation ')' | '[' class ']' | '.' | escape | byte
+	Fragment parse_atom() {
+		char c = this->text[this->position++];
+		bitset<256> bytes;
+		switch (c) {
+			case '(': {
+				Fragment inner = this->parse_alternation();
+				if (this->at_end() || this->text[this->position] != ')') {
+					this->fail("missing )");
+				}
+				this->position++;
+				return inner;
+			}
+			case '*':
+			case '+':
+			case '?':
+				this->fail("nothing to repeat");
+				break;
+			case '[':
+				return this->byte_fragment(this->parse_class());
+			case '.':
+				bytes.set();
+				bytes.reset('\n');
+				return this->byte_fragment(bytes);
+			case '\\':
+				bytes.set(this->parse_escape());
+				return this->byte_fragment(bytes);
+			default:
+				bytes.set((unsigned char) c);
+				return this->byte_fragment(bytes);
+		}
+		return this->empty_fragment();
+	}
+	
+	// the byte after a backslash
+	unsigned char parse_escape() {
+		if (this->at_end()) {
+			this->fail("dangling escape");
+		}
+		char c = this->text[this->position++];
+		switch (c) {
+			case 't': return '\t';
+			case 'n': return '\n';
+			case 'v': return '\v';
+			case 'f': return '\f';
+			case 'r': return '\r';
+			case 'x': {
+				unsigned int value = 0;
+				for (unsigned int i = 0; i < 2; i++) {
+					if (this->at_end() || !isxdigit(this->text[this->position])) {
+						this->fail("bad hex escape");
+					}
+					char digit = (char) tolower(this->text[this->position++]);
+					value = value * 16 + (unsigned int) (isdigit(digit) ? digit - '0' : digit - 'a' + 10);
+				}
+				return (unsigned char) value;
+			}
+			default:
+				return (unsigned char) c;
+		}
+	}
+	
+	// the bytes of a class, after its opening bracket. a ] first
+	// in the class and a - last in it stand for themselves
+	bitset<256> parse_class() {
+		bitset<256> bytes;
+		bool negated = !this->at_end() && this->text[this->position] == '^';
+		if (negated) {
+			this->position++;
+		}
+		bool first = true;
+		while (true) {
+			if (this->at_end()) {
+				this->fail("missing ]");
+			}
+			if (this->text[this->position] == ']' && !first) {
+				this->position++;
+				break;
+			}
+			first = false;
+			unsigned char low = this->parse_class_byte();
+			unsigned char high = low;
+			if (this->position + 1 < this->text.size() && this->text[this->position] == '-'
+				&& this->text[this->position + 1] != ']') {
+				this->position++;
+				high = this->parse_class_byte();
+				if (high < low) {
+					this->fail("bad range");
+				}
+			}
+			for (unsigned int b = low; b <= high; b++) {
+				bytes.set(b);
+			}
+		}
+		if (negated) {
+			bytes.flip();
+		}
+		return bytes;
+	}
+	
+	unsigned char parse_class_byte() {
+		char c = this->text[this->position++];
+		return (c == '\\') ? this->parse_escape() : (unsigned char) c;
+	}
+	
+	// adds every state reachable through empty edges, sorted
+	void close(vector<int>& states) {
+		vector<bool> in_set(this->nfa.size(), false);
+		vector<int> work = states;
+		for (auto s = states.begin(); s != states.end(); ++s) {
+			in_set[*s] = true;
+		}
+		while (!work.empty()) {
+			int s = work.back();
+			work.pop_back();
+			for (auto e = this->nfa[s].empty.begin(); e != this->nfa[s].empty.end(); ++e) {
+				if (!in_set[*e]) {
+					in_set[*e] = true;
+					states.push_back(*e);
+					work.push_back(*e);
+				}
+			}
+		}
+		sort(states.begin(), states.end());
+	}
+
+public:
+	// ctor
+	RegexBuilder() : position(0) {}
+	
+	// dtor
+	virtual ~RegexBuilder() = default;
+	
+	// adds a token's pattern, lower priority values win when two
+	// patterns match the same text
+	void add_token(string name, string pattern, unsigned int priority) {
+		this->patterns.push_back(Pattern { name, pattern, priority });
+	}
+	
+	// a pattern matching exactly the given text
+	static string escape(string literal) {
+		string escaped;
+		for (auto c = literal.begin(); c != literal.end(); ++c) {
+			if (!isalnum(*c)) {
+				escaped += '\\';
+			}
+			escaped += *c;
+		}
+		return escaped;
+	}
+	
+	// builds the minimized DFA for every pattern added so far
+	CompiledMachinePtr build() {
+		// one NFA, with an empty edge from its start to every pattern
+		this->nfa.clear();
+		int start = this->new_state();
+		for (unsigned int i = 0; i < this->patterns.size(); i++) {
+			this->text = this->patterns[i].pattern;
+			this->position = 0;
+			Fragment fragment = this->parse_alternation();
+			if (!this->at_end()) {
+				this->fail("unmatched )");
+			}
+			this->nfa[start].empty.push_back(fragment.start);
+			this->nfa[fragment.end].accepts = (int) i;
+		}
+		
+		// bytes lying on exactly the same edges are stepped together
+		uint8_t byte_classes[256];
+		vector<unsigned char> representatives;
+		map<vector<bool>, unsigned int> signatures;
+		for (unsigned int b = 0; b < 256; b++) {
+			vector<bool> signature;
+			for (auto s = this->nfa.begin(); s != this->nfa.end(); ++s) {
+				if (s->target != -1) {
+					signature.push_back(s->bytes[b]);
+				}
+			}
+			auto found = signatures.find(signature);
+			if (found == signatures.end()) {
+				found = signatures.insert(pair<vector<bool>, unsigned int>(
+					signature, (unsigned int) representatives.size())).first;
+				representatives.push_back((unsigned char) b);
+			}
+			byte_classes[b] = (uint8_t) found->second;
+		}
+		unsigned int num_classes = (unsigned int) representatives.size();
+		
+		// subset construction, the empty set is the dead state and
+		// the closure of the start is the initial state
+		map<vector<int>, uint16_t> ids;
+		vector<vector<int>> sets;
+		vector<uint16_t> table(num_classes, (uint16_t) CompiledMachine::dead_state);
+		vector<int> initial = { start };
+		this->close(initial);
+		ids[vector<int>()] = CompiledMachine::dead_state;
+		ids[initial] = CompiledMachine::initial_state;
+		sets.push_back(vector<int>());
+		sets.push_back(initial);
+		for (size_t d = CompiledMachine::initial_state; d < sets.size(); d++) {
+			for (unsigned int c = 0; c < num_classes; c++) {
+				vector<int> moved;
+				for (auto s = sets[d].begin(); s != sets[d].end(); ++s) {
+					if (this->nfa[*s].target != -1 && this->nfa[*s].bytes[representatives[c]]) {
+						moved.push_back(this->nfa[*s].target);
+					}
+				}
+				this->close(moved);
+				auto found = ids.find(moved);
+				if (found == ids.end()) {
+					if (sets.size() >= UINT16_MAX) {
+						throw string("Patterns have too many states to compile");
+					}
+					found = ids.insert(pair<vector<int>, uint16_t>(
+						moved, (uint16_t) sets.size())).first;
+					sets.push_back(moved);
+				}
+				table.push_back(found->second);
+			}
+		}
+		
+		// fill in the compiled machine, tagging final states
+		// with the name of the winning pattern
+		CompiledMachinePtr compiled = CompiledMachinePtr(
+			new CompiledMachine((unsigned int) sets.size(), num_classes));
+		for (unsigned int b = 0; b < 256; b++) {
+			compiled->byte_classes[b] = byte_classes[b];
+		}
+		compiled->table.swap(table);
+		map<string, uint16_t> tags;
+		for (unsigned int d = 0; d < sets.size(); d++) {
+			int winner = -1;
+			for (auto s = sets[d].begin(); s != sets[d].end(); ++s) {
+				int accepts = this->nfa[*s].accepts;
+				if (accepts != -1 && (winner == -1
+					|| this->patterns[accepts].priority < this->patterns[winner].priority
+					|| (this->patterns[accepts].priority == this->patterns[winner].priority
+						&& accepts < winner))) {
+					winner = accepts;
+				}
+			}
+			if (winner == -1) {
+				continue;
+			}
+			compiled->accept_bits[d >> 5] |= (1u << (d & 31));
+			string accept_name = this->patterns[winner].name;
+			if (tags.find(accept_name) == tags.end()) {
+				tags[accept_name] = (uint16_t) compiled->accept_names.size();
+				compiled->accept_names.push_back(accept_name);
+			}
+			compiled->accept_tags[d] = tags[accept_name];
+		}
+		this->nfa.clear();
+		
+		// same shrinking as a compiled FA
+		compiled->compute_byte_classes();
+		compiled->minimize();
+		compiled->compute_byte_classes();
+		return compiled;
 	}
 };
 
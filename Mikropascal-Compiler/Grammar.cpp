@@ -0,0 +1,361 @@
+#include "Grammar.hpp"
+
+Grammar::Grammar() {
+	this->alternatives.resize(RULE_COUNT);
+	this->build_rules();
+	this->build_first();
+	this->build_predict();
+}
+
+GrammarPtr Grammar::get_mikropascal() {
+	static GrammarPtr grammar = GrammarPtr(new Grammar());
+	return grammar;
+}
+
+GrammarSymbol Grammar::term(TokType token) {
+	return GrammarSymbol { TERMINAL, (uint16_t) token };
+}
+
+GrammarSymbol Grammar::rule(unsigned int rule) {
+	return GrammarSymbol { NONTERMINAL, (uint16_t) rule };
+}
+
+GrammarSymbol Grammar::act(GrammarAction action) {
+	return GrammarSymbol { ACTION, (uint16_t) action };
+}
+
+void Grammar::add(unsigned int rule, initializer_list<GrammarSymbol> symbols) {
+	this->add_production(rule, PREDICTED, MP_ERROR, symbols);
+}
+
+void Grammar::add_guarded(unsigned int rule, TokType guard, initializer_list<GrammarSymbol> symbols) {
+	this->add_production(rule, GUARDED, guard, symbols);
+}
+
+void Grammar::add_otherwise(unsigned int rule, initializer_list<GrammarSymbol> symbols) {
+	this->add_production(rule, OTHERWISE, MP_ERROR, symbols);
+}
+
+void Grammar::add_production(unsigned int rule, ProductionKind kind, TokType guard,
+							 initializer_list<GrammarSymbol> symbols) {
+	Production production;
+	production.rule = (uint16_t) rule;
+	production.kind = kind;
+	production.guard = guard;
+	production.first_symbol = (uint32_t) this->symbols.size();
+	production.symbol_count = (uint32_t) symbols.size();
+	this->symbols.insert(this->symbols.end(), symbols.begin(), symbols.end());
+	this->alternatives[rule].push_back((uint16_t) this->productions.size());
+	this->productions.push_back(production);
+}
+
+void Grammar::build_rules() {
+	// program structure
+	this->add(SYSTEM_GOAL, { rule(PROGRAM), rule(EOF_RULE) });
+	this->add(PROGRAM, { rule(PROGRAM_HEADING), term(MP_SEMI_COLON), rule(BLOCK), term(MP_PERIOD) });
+	this->add(PROGRAM_HEADING, { term(MP_PROGRAM), act(BEGIN_PROGRAM),
+		rule(PROGRAM_IDENTIFIER), act(SOFT_END_GENERATE) });
+	this->add(BLOCK, { rule(VARIABLE_DECL_PART), act(BEGIN_CALLABLE_PART),
+		rule(PROCEDURE_AND_FUNCTION_DECL_PART), act(END_GENERATE), rule(STATEMENT_PART) });
+	this->add(EOF_RULE, { term(MP_EOF) });
+	this->add_otherwise(EOF_RULE, { act(EOF_ERROR) });
+	this->add(EPSILON, { });
+	
+	// variable declarations
+	this->add(VARIABLE_DECL_PART, { term(MP_VAR), rule(VARIABLE_DECL), term(MP_SEMI_COLON),
+		rule(VARIABLE_DECL_TAIL) });
+	this->add(VARIABLE_DECL_PART, { rule(EPSILON) });
+	this->add(VARIABLE_DECL_TAIL, { rule(VARIABLE_DECL), term(MP_SEMI_COLON), rule(VARIABLE_DECL_TAIL) });
+	this->add(VARIABLE_DECL_TAIL, { rule(EPSILON) });
+	this->add(VARIABLE_DECL, { act(BEGIN_DATA_SYMBOL), rule(IDENTFIER_LIST), term(MP_COLON),
+		rule(TYPE), act(END_DATA_SYMBOL) });
+	this->add(TYPE, { term(MP_INTEGER) });
+	this->add(TYPE, { term(MP_FLOAT) });
+	this->add(TYPE, { term(MP_STRING) });
+	this->add(TYPE, { term(MP_BOOLEAN) });
+	this->add_otherwise(TYPE, { act(TYPE_ERROR) });
+	
+	// procedure and function declarations, the empty
+	// alternative leaves no epsilon node
+	this->add(PROCEDURE_AND_FUNCTION_DECL_PART, { rule(PROCEDURE_DECL),
+		rule(PROCEDURE_AND_FUNCTION_DECL_PART) });
+	this->add(PROCEDURE_AND_FUNCTION_DECL_PART, { rule(FUNCTION_DECL),
+		rule(PROCEDURE_AND_FUNCTION_DECL_PART) });
+	this->add(PROCEDURE_AND_FUNCTION_DECL_PART, { });
+	this->add(PROCEDURE_DECL, { rule(PROCEDURE_HEAD), term(MP_SEMI_COLON), act(BEGIN_PROCEDURE_DEFINITION),
+		rule(BLOCK), act(END_GENERATE), term(MP_SEMI_COLON), act(LEAVE_SCOPE) });
+	this->add(FUNCTION_DECL, { rule(FUNCTION_HEAD), term(MP_SEMI_COLON), act(BEGIN_FUNCTION_DEFINITION),
+		rule(BLOCK), act(END_GENERATE), term(MP_SEMI_COLON), act(LEAVE_SCOPE) });
+	this->add(PROCEDURE_HEAD, { act(BEGIN_CALLABLE_SYMBOL), term(MP_PROCEDURE), rule(PROCEDURE_IDENTIFIER),
+		rule(OPT_FORMAL_PARAM_LIST), act(END_PROCEDURE_SYMBOL) });
+	this->add(FUNCTION_HEAD, { act(BEGIN_CALLABLE_SYMBOL), term(MP_FUNCTION), rule(FUNCTION_IDENTFIER),
+		rule(OPT_FORMAL_PARAM_LIST), term(MP_COLON), rule(TYPE), act(END_FUNCTION_SYMBOL) });
+	this->add(OPT_FORMAL_PARAM_LIST, { term(MP_LEFT_PAREN), rule(FORMAL_PARAM),
+		rule(FORMAL_PARAM_SECTION_TAIL), term(MP_RIGHT_PAREN) });
+	this->add(OPT_FORMAL_PARAM_LIST, { rule(EPSILON) });
+	this->add(FORMAL_PARAM_SECTION_TAIL, { term(MP_SEMI_COLON), rule(FORMAL_PARAM),
+		rule(FORMAL_PARAM_SECTION_TAIL) });
+	this->add(FORMAL_PARAM_SECTION_TAIL, { rule(EPSILON) });
+	this->add(FORMAL_PARAM, { rule(VALUE_PARAM_SECTION) });
+	this->add(FORMAL_PARAM, { rule(VARIABLE_PARAM_SECTION) });
+	this->add(FORMAL_PARAM, { });
+	this->add(VALUE_PARAM_SECTION, { rule(IDENTFIER_LIST), term(MP_COLON), rule(TYPE) });
+	this->add(VARIABLE_PARAM_SECTION, { term(MP_VAR), rule(IDENTFIER_LIST), term(MP_COLON), rule(TYPE) });
+	
+	// statements, anything else is an empty statement
+	this->add(STATEMENT_PART, { rule(COMPOUND_STATEMENT) });
+	this->add(COMPOUND_STATEMENT, { term(MP_BEGIN), rule(STATEMENT_SEQUENCE), term(MP_END) });
+	this->add(STATEMENT_SEQUENCE, { rule(STATEMENT), rule(STATEMENT_TAIL) });
+	this->add(STATEMENT_TAIL, { term(MP_SEMI_COLON), rule(STATEMENT), rule(STATEMENT_TAIL) });
+	this->add(STATEMENT_TAIL, { rule(EPSILON) });
+	this->add_guarded(STATEMENT, MP_READ, { act(BEGIN_READ), rule(READ_STATEMENT), act(END_GENERATE) });
+	this->add_guarded(STATEMENT, MP_READLN, { act(BEGIN_READLN), rule(READ_STATEMENT), act(END_GENERATE) });
+	this->add_guarded(STATEMENT, MP_WRITE, { act(BEGIN_WRITE), rule(WRITE_STATEMENT), act(END_GENERATE) });
+	this->add_guarded(STATEMENT, MP_WRITELN, { act(BEGIN_WRITELN), rule(WRITE_STATEMENT), act(END_GENERATE) });
+	this->add(STATEMENT, { act(BEGIN_ASSIGNMENT), rule(ASSIGNMENT_STATEMENT), act(END_GENERATE) });
+	this->add(STATEMENT, { rule(IF_STATEMENT) });
+	this->add(STATEMENT, { act(BEGIN_WHILE), rule(WHILE_STATEMENT), act(END_GENERATE) });
+	this->add(STATEMENT, { act(BEGIN_REPEAT), rule(REPEAT_STATEMENT), act(END_GENERATE) });
+	this->add(STATEMENT, { act(BEGIN_FOR), rule(FOR_STATEMENT), act(END_GENERATE) });
+	this->add_guarded(STATEMENT, MP_PROCEDURE, { act(BEGIN_PROCEDURE_CALL), rule(PROCEDURE_STATEMENT),
+		act(END_GENERATE) });
+	this->add(STATEMENT, { rule(COMPOUND_STATEMENT) });
+	this->add(STATEMENT, { rule(EMPTY_STATEMENT) });
+	this->add(EMPTY_STATEMENT, { });
+	this->add(READ_STATEMENT, { term(MP_READ), term(MP_LEFT_PAREN), rule(READ_PARAMETER),
+		rule(READ_PARAMETER_TAIL), term(MP_RIGHT_PAREN) });
+	this->add(READ_STATEMENT, { term(MP_READLN), term(MP_LEFT_PAREN), rule(READ_PARAMETER),
+		rule(READ_PARAMETER_TAIL), term(MP_RIGHT_PAREN) });
+	this->add(READ_PARAMETER_TAIL, { term(MP_COMMA), rule(READ_PARAMETER), rule(READ_PARAMETER_TAIL) });
+	this->add(READ_PARAMETER_TAIL, { rule(EPSILON) });
+	this->add(READ_PARAMETER, { rule(VARIABLE_IDENTIFIER) });
+	this->add(WRITE_STATEMENT, { term(MP_WRITELN), term(MP_LEFT_PAREN), rule(WRITE_PARAMETER),
+		rule(WRITE_PARAMETER_TAIL), term(MP_RIGHT_PAREN) });
+	this->add(WRITE_STATEMENT, { term(MP_WRITE), term(MP_LEFT_PAREN), rule(WRITE_PARAMETER),
+		rule(WRITE_PARAMETER_TAIL), term(MP_RIGHT_PAREN) });
+	this->add(WRITE_PARAMETER_TAIL, { term(MP_COMMA), rule(WRITE_PARAMETER), rule(WRITE_PARAMETER_TAIL) });
+	this->add(WRITE_PARAMETER_TAIL, { rule(EPSILON) });
+	this->add(WRITE_PARAMETER, { rule(ORDINAL_EXPRESSION) });
+	this->add(ASSIGNMENT_STATEMENT, { rule(VARIABLE_IDENTIFIER), term(MP_ASSIGNMENT), rule(EXPRESSION) });
+	
+	// control flow, the else links up with its if
+	this->add(IF_STATEMENT, { act(BEGIN_IF), term(MP_IF), rule(BOOLEAN_EXPRESSION), term(MP_THEN),
+		rule(STATEMENT), act(END_GENERATE), rule(ELSE_CHECK), act(END_IF) });
+	this->add(ELSE_CHECK, { act(BEGIN_ELSE), rule(OPTIONAL_ELSE_PART), act(END_GENERATE) });
+	this->add(ELSE_CHECK, { });
+	this->add(OPTIONAL_ELSE_PART, { term(MP_ELSE), rule(STATEMENT) });
+	this->add(OPTIONAL_ELSE_PART, { rule(EPSILON) });
+	
+	// loops
+	this->add(REPEAT_STATEMENT, { term(MP_REPEAT), rule(STATEMENT_SEQUENCE), term(MP_UNTIL),
+		rule(BOOLEAN_EXPRESSION) });
+	this->add(WHILE_STATEMENT, { term(MP_WHILE), rule(BOOLEAN_EXPRESSION), term(MP_DO), rule(STATEMENT) });
+	this->add(FOR_STATEMENT, { term(MP_FOR), rule(CONTROL_VARIABLE), term(MP_ASSIGNMENT),
+		rule(INITIAL_VALUE), rule(STEP_VALUE), rule(FINAL_VALUE), term(MP_DO), rule(STATEMENT) });
+	this->add(CONTROL_VARIABLE, { rule(VARIABLE_IDENTIFIER) });
+	this->add(INITIAL_VALUE, { rule(ORDINAL_EXPRESSION) });
+	this->add(STEP_VALUE, { term(MP_TO) });
+	this->add(STEP_VALUE, { term(MP_DOWNTO) });
+	this->add_otherwise(STEP_VALUE, { act(WEIRD_ERROR) });
+	this->add(FINAL_VALUE, { rule(ORDINAL_EXPRESSION) });
+	
+	// procedure calls, a parameter tail starts at
+	// its comma but does not match it
+	this->add(PROCEDURE_STATEMENT, { rule(PROCEDURE_IDENTIFIER), rule(OPTIONAL_ACTUAL_PARAMETER_LIST) });
+	this->add(OPTIONAL_ACTUAL_PARAMETER_LIST, { term(MP_LEFT_PAREN), rule(ACTUAL_PARAMETER),
+		rule(ACTUAL_PARAMETER_TAIL) });
+	this->add(OPTIONAL_ACTUAL_PARAMETER_LIST, { rule(EPSILON) });
+	this->add_guarded(ACTUAL_PARAMETER_TAIL, MP_COMMA, { rule(ACTUAL_PARAMETER), rule(ACTUAL_PARAMETER_TAIL) });
+	this->add(ACTUAL_PARAMETER_TAIL, { rule(EPSILON) });
+	this->add(ACTUAL_PARAMETER, { rule(ORDINAL_EXPRESSION) });
+	
+	// expressions are climbed by precedence rather than expanded
+	// here, the parser builds each one into a tree of its own
+	this->add(EXPRESSION, { act(PARSE_EXPRESSION) });
+	
+	// identifiers
+	this->add(PROGRAM_IDENTIFIER, { term(MP_ID) });
+	this->add(VARIABLE_IDENTIFIER, { term(MP_ID) });
+	this->add(PROCEDURE_IDENTIFIER, { term(MP_ID) });
+	this->add(FUNCTION_IDENTFIER, { term(MP_ID) });
+	this->add(BOOLEAN_EXPRESSION, { rule(EXPRESSION) });
+	this->add(ORDINAL_EXPRESSION, { rule(EXPRESSION) });
+	this->add(IDENTFIER_LIST, { term(MP_ID), rule(IDENTFIER_TAIL) });
+	this->add(IDENTFIER_TAIL, { term(MP_COMMA), term(MP_ID), rule(IDENTFIER_TAIL) });
+	this->add(IDENTFIER_TAIL, { rule(EPSILON) });
+}
+
+bool Grammar::production_first(const Production& production, bitset<token_count>& tokens) {
+	// add the first tokens of a production, true if
+	// all of its symbols can match nothing
+	if (production.kind == GUARDED) {
+		tokens.set(production.guard);
+		return false;
+	}
+	for (uint32_t i = 0; i < production.symbol_count; i++) {
+		const GrammarSymbol& symbol = this->symbols[production.first_symbol + i];
+		if (symbol.kind == TERMINAL) {
+			tokens.set(symbol.value);
+			return false;
+		} else if (symbol.kind == NONTERMINAL) {
+			tokens |= this->first[symbol.value];
+			if (!this->nullable[symbol.value]) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void Grammar::build_first() {
+	// grow the first sets until nothing changes,
+	// actions match nothing and are skipped over
+	this->first.assign(RULE_COUNT, bitset<token_count>());
+	this->nullable.assign(RULE_COUNT, false);
+	bool changed = true;
+	while (changed) {
+		changed = false;
+		for (auto production = this->productions.begin(); production != this->productions.end(); production++) {
+			if (production->kind == OTHERWISE) {
+				continue;
+			}
+			bitset<token_count> tokens = this->first[production->rule];
+			bool empty = this->production_first(*production, tokens);
+			if (tokens != this->first[production->rule]) {
+				this->first[production->rule] = tokens;
+				changed = true;
+			}
+			if (empty && !this->nullable[production->rule]) {
+				this->nullable[production->rule] = true;
+				changed = true;
+			}
+		}
+	}
+}
+
+void Grammar::build_predict() {
+	// one production per rule and token, two alternatives
+	// starting with the same token is a conflict
+	const uint16_t unset = UINT16_MAX;
+	this->predict.assign(RULE_COUNT * token_count, unset);
+	for (unsigned int rule = 0; rule < RULE_COUNT; rule++) {
+		vector<uint16_t>& rule_alternatives = this->alternatives[rule];
+		if (rule_alternatives.empty()) {
+			continue;
+		}
+		uint16_t* row = &this->predict[rule * token_count];
+		uint16_t fallback = rule_alternatives.back();
+		bool has_otherwise = false;
+		for (auto alternative = rule_alternatives.begin(); alternative != rule_alternatives.end(); alternative++) {
+			const Production& production = this->productions[*alternative];
+			if (production.kind == OTHERWISE) {
+				if (has_otherwise) {
+					throw string("Grammar rule " + Grammar::get_rule_name(rule)
+								 + " has more than one otherwise alternative");
+				}
+				has_otherwise = true;
+				fallback = *alternative;
+				continue;
+			}
+			bitset<token_count> tokens;
+			this->production_first(production, tokens);
+			for (unsigned int token = 0; token < token_count; token++) {
+				if (!tokens.test(token)) {
+					continue;
+				}
+				if (row[token] != unset) {
+					throw string("Grammar conflict in " + Grammar::get_rule_name(rule)
+								 + " on " + get_token_info((TokType) token).first);
+				}
+				row[token] = *alternative;
+			}
+		}
+		for (unsigned int token = 0; token < token_count; token++) {
+			if (row[token] == unset) {
+				row[token] = fallback;
+			}
+		}
+	}
+	
+	// every rule used has to be defined
+	for (auto symbol = this->symbols.begin(); symbol != this->symbols.end(); symbol++) {
+		if (symbol->kind == NONTERMINAL && this->alternatives[symbol->value].empty()) {
+			throw string("Grammar rule " + Grammar::get_rule_name(symbol->value) + " has no productions");
+		}
+	}
+}
+
+bool Grammar::get_creates_node(unsigned int rule) {
+	return rule <= ROOT;
+}
+
+string Grammar::get_rule_name(unsigned int rule) {
+	if (rule <= ROOT) {
+		return get_rule_info((ParseType) rule);
+	}
+	switch (rule) {
+		case ELSE_CHECK:
+			return "ELSE_CHECK";
+		default:
+			return "UNKNOWN_RULE";
+	}
+}
+
+size_t Grammar::get_production_count() {
+	return this->productions.size();
+}
+
+size_t Grammar::get_symbol_count() {
+	return this->symbols.size();
+}
+
+void Grammar::display_table() {
+	// each production with the tokens that pick it,
+	// hidden rules in brackets and actions marked @
+	static const char* action_names[] = { "BEGIN_DATA_SYMBOL", "END_DATA_SYMBOL",
+		"BEGIN_CALLABLE_SYMBOL", "END_PROCEDURE_SYMBOL", "END_FUNCTION_SYMBOL", "LEAVE_SCOPE",
+		"BEGIN_PROGRAM", "SOFT_END_GENERATE", "END_GENERATE", "BEGIN_CALLABLE_PART",
+		"BEGIN_PROCEDURE_DEFINITION", "BEGIN_FUNCTION_DEFINITION", "BEGIN_PROCEDURE_CALL",
+		"BEGIN_READ", "BEGIN_READLN", "BEGIN_WRITE", "BEGIN_WRITELN", "BEGIN_ASSIGNMENT",
+		"BEGIN_IF", "BEGIN_ELSE", "END_IF", "BEGIN_WHILE", "BEGIN_REPEAT", "BEGIN_FOR", "PARSE_EXPRESSION",
+		"TYPE_ERROR", "WEIRD_ERROR", "EOF_ERROR" };
+	for (unsigned int rule = 0; rule < RULE_COUNT; rule++) {
+		for (auto alternative = this->alternatives[rule].begin();
+			 alternative != this->alternatives[rule].end(); alternative++) {
+			const Production& production = this->productions[*alternative];
+			string name = Grammar::get_rule_name(rule);
+			cout << (Grammar::get_creates_node(rule) ? name : "[" + name + "]") << " ->";
+			for (uint32_t i = 0; i < production.symbol_count; i++) {
+				const GrammarSymbol& symbol = this->symbols[production.first_symbol + i];
+				if (symbol.kind == TERMINAL) {
+					cout << " " << get_token_info((TokType) symbol.value).first;
+				} else if (symbol.kind == NONTERMINAL) {
+					string used = Grammar::get_rule_name(symbol.value);
+					cout << " " << (Grammar::get_creates_node(symbol.value) ? used : "[" + used + "]");
+				} else {
+					cout << " @" << action_names[symbol.value];
+				}
+			}
+	
+			// the tokens that pick this production, and whether
+			// it is taken on anything else too
+			bitset<token_count> tokens;
+			if (production.kind != OTHERWISE) {
+				this->production_first(production, tokens);
+			}
+			bool fallback = false;
+			cout << endl << setw(8) << "" << "on";
+			for (unsigned int token = 0; token < token_count; token++) {
+				if (tokens.test(token)) {
+					cout << " " << get_token_info((TokType) token).first;
+				} else if (this->predict[rule * token_count + token] == *alternative) {
+					fallback = true;
+				}
+			}
+			if (fallback) {
+				cout << (tokens.any() ? " or anything else" : " anything else");
+			}
+			cout << endl;
+		}
+	}
+}
@@ -0,0 +1,144 @@
+#ifndef GRAMMAR_HPP_
+#define GRAMMAR_HPP_
+
+#include "Standard.hpp"
+#include "Tokens.hpp"
+#include "Rules.hpp"
+
+class Grammar;
+using GrammarPtr = shared_ptr<Grammar>;
+
+// rules that steer the parse but leave no node in the
+// tree, numbered on from the parse types
+enum HiddenRule {
+	ELSE_CHECK = ROOT + 1,
+	RULE_COUNT
+};
+
+// semantic actions the table driven parser hands back
+// to the parser as it reaches them in a production
+enum GrammarAction {
+	// symbol table
+	BEGIN_DATA_SYMBOL,
+	END_DATA_SYMBOL,
+	BEGIN_CALLABLE_SYMBOL,
+	END_PROCEDURE_SYMBOL,
+	END_FUNCTION_SYMBOL,
+	LEAVE_SCOPE,
+	// code generation
+	BEGIN_PROGRAM,
+	SOFT_END_GENERATE,
+	END_GENERATE,
+	BEGIN_CALLABLE_PART,
+	BEGIN_PROCEDURE_DEFINITION,
+	BEGIN_FUNCTION_DEFINITION,
+	BEGIN_PROCEDURE_CALL,
+	BEGIN_READ,
+	BEGIN_READLN,
+	BEGIN_WRITE,
+	BEGIN_WRITELN,
+	BEGIN_ASSIGNMENT,
+	BEGIN_IF,
+	BEGIN_ELSE,
+	END_IF,
+	BEGIN_WHILE,
+	BEGIN_REPEAT,
+	BEGIN_FOR,
+	// expressions, built by the precedence parser
+	PARSE_EXPRESSION,
+	// errors the grammar recovers from
+	TYPE_ERROR,
+	WEIRD_ERROR,
+	EOF_ERROR
+};
+
+// what a symbol on the right of a production is
+enum GrammarSymbolKind : uint8_t {
+	TERMINAL,
+	NONTERMINAL,
+	ACTION,
+	// pushed by the engine under a rule's symbols,
+	// closes the rule's node once they are done
+	RULE_END
+};
+
+struct GrammarSymbol {
+	GrammarSymbolKind kind;
+	uint16_t value;
+};
+
+// how an alternative is chosen
+enum ProductionKind : uint8_t {
+	// on the first tokens of its symbols
+	PREDICTED,
+	// on one given token only
+	GUARDED,
+	// on any token no other alternative takes, never part
+	// of the rule's first tokens (error fallbacks)
+	OTHERWISE
+};
+
+// one alternative of a rule, its symbols are a
+// range of the grammar's symbol list
+struct Production {
+	uint16_t rule;
+	ProductionKind kind;
+	TokType guard;
+	uint32_t first_symbol;
+	uint32_t symbol_count;
+};
+
+// the Mikropascal grammar as data, and the LL(1) predict table
+// generated from it. rules without an alternative for the lookahead
+// take their otherwise alternative, or their last one, the same as
+// the trailing else of a recursive descent parser
+class Grammar {
+private:
+	vector<GrammarSymbol> symbols;
+	vector<Production> productions;
+	vector<vector<uint16_t>> alternatives;
+	
+	// rule x token, the production to expand
+	enum { token_count = MP_ERROR + 1 };
+	vector<uint16_t> predict;
+	
+	// first tokens and nullability of every rule
+	vector<bitset<token_count>> first;
+	vector<bool> nullable;
+	
+	static GrammarSymbol term(TokType token);
+	static GrammarSymbol rule(unsigned int rule);
+	static GrammarSymbol act(GrammarAction action);
+	void add(unsigned int rule, initializer_list<GrammarSymbol> symbols);
+	void add_guarded(unsigned int rule, TokType guard, initializer_list<GrammarSymbol> symbols);
+	void add_otherwise(unsigned int rule, initializer_list<GrammarSymbol> symbols);
+	void add_production(unsigned int rule, ProductionKind kind, TokType guard,
+						initializer_list<GrammarSymbol> symbols);
+	
+	// the productions of the language, then the table from them
+	void build_rules();
+	void build_first();
+	bool production_first(const Production& production, bitset<token_count>& tokens);
+	void build_predict();
+public:
+	Grammar();
+	virtual ~Grammar() = default;
+	
+	// built once, shared by every parser
+	static GrammarPtr get_mikropascal();
+	
+	// the production a rule expands to on a lookahead token
+	inline const Production& get_production(unsigned int rule, TokType lookahead) const {
+		return this->productions[this->predict[rule * token_count + lookahead]];
+	}
+	inline const GrammarSymbol& get_symbol(uint32_t index) const {
+		return this->symbols[index];
+	}
+	static bool get_creates_node(unsigned int rule);
+	static string get_rule_name(unsigned int rule);
+	size_t get_production_count();
+	size_t get_symbol_count();
+	void display_table();
+};
+
+#endif /* GRAMMAR_HPP_ */
@@ -30,16 +30,6 @@ static void report_msg_type(const string& type, const string& msg) {
     cout << "[ " << type << ": " << msg << " ]" << endl;
 }
 
-static void report_parse(const string& msg, const unsigned int depth) {
-    if (DEBUG_OUTPUT) {
-        cout << "[ ";
-        for (unsigned int i = 0; i < depth; i++) {
-            cout << " ";
-        }
-        cout << msg << " ]" << endl;
-    }
-}
-
 // returns all variants of a character (upper and lowercase)
 static pair<char, char> all_char_variants(char c) {
     pair<char, char> char_pair;
@@ -1,46 +1,256 @@
 #include "Input.hpp"
 
-Input::Input(string filename) {
-	// input constructor
-	// set up line capture (for getting file lines)
-    string line;
-	this->lines = StringListPtr(new StringList());
-    // open file
-	ifstream file_to_compile(filename, ios::binary);
-    if (file_to_compile.is_open()) {
-        while (std::getline(file_to_compile, line)) {
-            for (string::iterator i = line.begin(); i != line.end(); i++)
-                if (*i == '\0')
-                    line.erase(i, i);
-            this->lines->push_back(line + '\n');
-        }
-        file_to_compile.close();
-    }
-    this->entire_input = StringPtr(new string(""));
-    for (StringList::iterator i = this->lines->begin();
-         i != this->lines->end(); i++) {
-        *this->entire_input += (*i);
-    }
+// platform file mapping
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+Input::Input() {
+	// input constructor, starts out empty
+	this->mapped_view = nullptr;
+	this->mapped_size = 0;
+	this->owned_input = nullptr;
+	this->stale_lines_from = SIZE_MAX;
+}
+
+Input::~Input() {
+	// release the mapping, if any
+	this->unmap_file();
+}
+
+bool Input::map_file(string filename) {
+	// map the file read-only so the scanner works on the file
+	// pages directly, without copying them into a string
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+							  NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	// only regular, non-empty files can be mapped
+	LARGE_INTEGER file_size;
+	if (GetFileType(file) != FILE_TYPE_DISK
+		|| !GetFileSizeEx(file, &file_size)
+		|| file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL) {
+		return false;
+	}
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	// the view keeps the mapping alive
+	CloseHandle(mapping);
+	if (view == NULL) {
+		return false;
+	}
+	this->mapped_size = (size_t) file_size.QuadPart;
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0) {
+		return false;
+	}
+	// only regular, non-empty files can be mapped
+	struct stat file_stat;
+	if (fstat(file, &file_stat) != 0
+		|| !S_ISREG(file_stat.st_mode)
+		|| file_stat.st_size == 0) {
+		close(file);
+		return false;
+	}
+	void* view = mmap(nullptr, (size_t) file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	// the mapping stays valid after the descriptor is closed
+	close(file);
+	if (view == MAP_FAILED) {
+		return false;
+	}
+	madvise(view, (size_t) file_stat.st_size, MADV_SEQUENTIAL);
+	this->mapped_size = (size_t) file_stat.st_size;
+#endif
+	this->mapped_view = view;
+	this->source = SourceView((const char*) view, this->mapped_size);
+	this->index_lines();
+	return true;
+}
+
+void Input::unmap_file() {
+	// unmap a mapped file
+	if (this->mapped_view != nullptr) {
+#ifdef _WIN32
+		UnmapViewOfFile(this->mapped_view);
+#else
+		munmap(this->mapped_view, this->mapped_size);
+#endif
+		this->mapped_view = nullptr;
+		this->mapped_size = 0;
+	}
+}
+
+void Input::read_stream(istream& stream) {
+	// fallback for inputs that cannot be mapped, read
+	// everything into a single owned buffer
+	ostringstream contents;
+	contents << stream.rdbuf();
+	this->owned_input = StringPtr(new string(contents.str()));
+	this->source = SourceView(this->owned_input->data(), this->owned_input->size());
+	this->index_lines();
+}
+
+void Input::index_lines() {
+	// record where every line starts, once, so positions can
+	// be looked up later instead of tracked while scanning
+	this->line_starts.clear();
+	this->line_starts.push_back(0);
+	this->index_lines_from(0);
+}
+
+void Input::index_lines_from(size_t offset) {
+	// add the lines starting after offset, which is the
+	// start of the last line indexed so far
+	const char* first = this->source.begin();
+	const char* last = this->source.end();
+	const char* next = first + offset;
+	while (next < last) {
+		// memchr is vectorized by the C library
+		const char* newline = (const char*) memchr(next, '\n', last - next);
+		if (newline == nullptr) {
+			break;
+		}
+		next = newline + 1;
+		this->line_starts.push_back((uint32_t) (next - first));
+	}
+}
+
+InputPtr Input::check_size(InputPtr input) {
+	// offsets into an input larger than this would wrap, so
+	// refuse it here rather than scan it wrongly
+	if (input->source.size() > (size_t) max_size) {
+		report_msg_type("Input Too Large", "Inputs must be under 4 GB");
+		return nullptr;
+	}
+	return input;
 }
 
 InputPtr Input::open_file(string filename) {
-	ifstream test_file(filename, ios::in|ios::binary|ios::ate);
-    if (test_file.is_open() && test_file.good()) {
-        test_file.close();
-        return InputPtr(new Input(filename));
-    }
-    else {
-        report_msg_type("Invalid File Path", "Check to ensure path is correct");
-        return nullptr;
-    }
+	// a dash reads from standard input
+	if (filename.compare("-") == 0) {
+		return Input::open_stdin();
+	}
+	InputPtr input = InputPtr(new Input());
+	if (input->map_file(filename)) {
+		return Input::check_size(input);
+	}
+	// could not map, try reading it as a stream
+	ifstream file_to_compile(filename, ios::in|ios::binary);
+	if (file_to_compile.is_open() && file_to_compile.good()) {
+		input->read_stream(file_to_compile);
+		file_to_compile.close();
+		return Input::check_size(input);
+	}
+	else {
+		report_msg_type("Invalid File Path", "Check to ensure path is correct");
+		return nullptr;
+	}
+}
+
+InputPtr Input::open_stdin() {
+	// standard input is always read into a buffer
+	InputPtr input = InputPtr(new Input());
+	input->read_stream(cin);
+	return Input::check_size(input);
+}
+
+InputPtr Input::open_string(string contents) {
+	// an input over a copy of a string, for testing
+	InputPtr input = InputPtr(new Input());
+	istringstream stream(contents);
+	input->read_stream(stream);
+	return Input::check_size(input);
+}
+
+SourceView Input::get_view() {
+	// the view is valid for as long as this input is, and
+	// until the input is next edited
+	return this->source;
+}
+
+bool Input::check_edit(size_t offset, size_t length, size_t replacement_size) {
+	// the replaced bytes have to be inside the input, and the
+	// edited input has to stay under the size limit
+	size_t size = this->source.size();
+	if (offset > size || length > size - offset) {
+		report_msg_type("Invalid Edit", "The edit runs past the end of the "
+						+ to_string(size) + " byte input");
+		return false;
+	}
+	if (replacement_size > (size_t) max_size || size - length > (size_t) max_size - replacement_size) {
+		report_msg_type("Input Too Large", "Inputs must be under 4 GB");
+		return false;
+	}
+	return true;
+}
+
+bool Input::replace(size_t offset, size_t length, const string& replacement) {
+	// edit the input in place, a mapped file is copied into an
+	// owned buffer the first time. the bytes after the edit are
+	// moved, which the scanner needs to see one contiguous input,
+	// -o times that apart from the rescan. the lines are only
+	// indexed again from the edit on once a position is asked for
+	if (!this->check_edit(offset, length, replacement.size())) {
+		return false;
+	}
+	if (this->owned_input == nullptr) {
+		this->owned_input = StringPtr(new string(this->source.begin(), this->source.size()));
+		this->unmap_file();
+	}
+	this->owned_input->replace(offset, length, replacement);
+	this->source = SourceView(this->owned_input->data(), this->owned_input->size());
+	this->stale_lines_from = min(this->stale_lines_from, offset);
+	return true;
+}
+
+void Input::update_lines() {
+	// a line starting at or before the first edit is where it
+	// was, the ones after it are found again
+	if (this->stale_lines_from == SIZE_MAX) {
+		return;
+	}
+	auto stale = upper_bound(this->line_starts.begin(), this->line_starts.end(),
+							 (uint32_t) this->stale_lines_from);
+	this->line_starts.erase(stale, this->line_starts.end());
+	this->stale_lines_from = SIZE_MAX;
+	this->index_lines_from(this->line_starts.back());
+}
+
+size_t Input::get_line_count() {
+	this->update_lines();
+	return this->line_starts.size();
+}
+
+unsigned long Input::get_line(size_t offset) {
+	// the line is the last one starting at or before offset
+	this->update_lines();
+	auto line = upper_bound(this->line_starts.begin(), this->line_starts.end(),
+							(uint32_t) offset);
+	return (unsigned long) (line - this->line_starts.begin());
 }
 
-StringPtr Input::detach_input() {
-	// copy and return detached input
-    return StringPtr(new string(*this->entire_input));
+unsigned long Input::get_column(size_t offset) {
+	// columns count bytes from the start of the line
+	unsigned long line = this->get_line(offset);
+	return (unsigned long) (offset - this->line_starts[line - 1] + 1);
 }
 
 void Input::print_input() {
 	// test print input
-	report_msg_type("Input", *this->entire_input);
+	report_msg_type("Input", this->source.to_string());
 }
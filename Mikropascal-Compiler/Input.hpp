@@ -6,21 +6,62 @@
 #include "Helper.hpp"
 
 class Input;
+class SourceView;
 using InputPtr = shared_ptr<Input>;
-using StringList = vector<string>;
-using StringListPtr = shared_ptr<StringList>;
+
+// a read-only span of characters (in the style of string_view),
+// it does not own the characters it points to
+class SourceView {
+private:
+	const char* first;
+	size_t length;
+public:
+	SourceView(): first(nullptr), length(0) {};
+	SourceView(const char* first, size_t length): first(first), length(length) {};
+	const char* begin() const { return this->first; }
+	const char* end() const { return this->first + this->length; }
+	size_t size() const { return this->length; }
+	bool empty() const { return this->length == 0; }
+	char operator[](size_t i) const { return this->first[i]; }
+	string to_string() const { return string(this->first, this->length); }
+};
 
 // input structure
 class Input {
 private:
-	// input in lines and string
-	StringListPtr lines;
-	StringPtr entire_input;
-	Input(string filename);
+	// view of the entire input
+	SourceView source;
+	// mapped file, if the input could be mapped
+	void* mapped_view;
+	size_t mapped_size;
+	// owned copy, if the input had to be read (pipes, stdin)
+	StringPtr owned_input;
+	// offset of the first character of each line, lines
+	// starting past an edit are indexed again when next asked for
+	vector<uint32_t> line_starts;
+	size_t stale_lines_from;
+	Input();
+	static InputPtr check_size(InputPtr input);
+	void index_lines();
+	void index_lines_from(size_t offset);
+	void update_lines();
+	bool map_file(string filename);
+	void unmap_file();
+	void read_stream(istream& stream);
 public:
-	virtual ~Input() = default;
+	// token and line offsets are 32 bits, so no input may be larger
+	enum { max_size = UINT32_MAX };
+	virtual ~Input();
 	static InputPtr open_file(string filename);
-	StringPtr detach_input();
+	static InputPtr open_stdin();
+	static InputPtr open_string(string contents);
+	SourceView get_view();
+	bool check_edit(size_t offset, size_t length, size_t replacement_size);
+	bool replace(size_t offset, size_t length, const string& replacement);
+	// line and column (both from 1) of a byte offset
+	size_t get_line_count();
+	unsigned long get_line(size_t offset);
+	unsigned long get_column(size_t offset);
 	void print_input();
 };
 
@@ -0,0 +1,49 @@
+#include "ParseTrace.hpp"
+
+ParseTrace::ParseTrace() {
+	this->events.resize(capacity);
+	this->clear();
+}
+
+void ParseTrace::clear() {
+	this->recorded = 0;
+}
+
+uint64_t ParseTrace::get_recorded() {
+	return this->recorded;
+}
+
+size_t ParseTrace::size() {
+	// the events still in the ring
+	return (size_t) min<uint64_t>(this->recorded, capacity);
+}
+
+const TraceEvent& ParseTrace::get_event(size_t index) {
+	// by age, the oldest event kept is index 0
+	uint64_t first = this->recorded - this->size();
+	return this->events[(first + index) & (capacity - 1)];
+}
+
+void ParseTrace::display(InputPtr input) {
+	// one line per event, indented by parse depth
+	if (this->recorded > this->size()) {
+		report_msg_type("Trace", to_string(this->recorded - this->size()) + " older events dropped");
+	}
+	for (size_t i = 0; i < this->size(); i++) {
+		const TraceEvent& event = this->get_event(i);
+		string text = "";
+		switch (event.kind) {
+			case RULE_EVENT:
+				text = "PARSE_" + get_rule_info((ParseType) event.value);
+				break;
+			case EPSILON_EVENT:
+				text = "EPSILON_REACHED";
+				break;
+			case MATCH_EVENT:
+				text = "Match: " + get_token_info((TokType) event.value).first;
+				break;
+		}
+		cout << "[ " << string(event.depth, ' ') << text << " @ "
+			 << input->get_line(event.offset) << ":" << input->get_column(event.offset) << " ]" << endl;
+	}
+}
@@ -0,0 +1,59 @@
+#ifndef PARSETRACE_HPP_
+#define PARSETRACE_HPP_
+
+#include "Standard.hpp"
+#include "Helper.hpp"
+#include "Rules.hpp"
+#include "Tokens.hpp"
+#include "Input.hpp"
+
+// what the parser was doing when an event was recorded
+enum TraceKind : uint8_t {
+	// entered a rule, the value is its parse type
+	RULE_EVENT,
+	// a rule took its empty alternative
+	EPSILON_EVENT,
+	// matched a token, the value is its kind
+	MATCH_EVENT
+};
+
+// one fixed size record, the source position is kept as an
+// offset and only turned into a line and column when decoded
+struct TraceEvent {
+	TraceKind kind;
+	uint16_t value;
+	uint32_t depth;
+	uint32_t offset;
+};
+
+// the last events of a parse in a ring, oldest overwritten first.
+// recording is a store and an increment, nothing is formatted
+// until the ring is decoded after the parse
+class ParseTrace {
+private:
+	enum { capacity = 1 << 16 };
+	vector<TraceEvent> events;
+	uint64_t recorded;
+public:
+	ParseTrace();
+	virtual ~ParseTrace() = default;
+	inline void record(TraceKind kind, uint16_t value, uint32_t depth, uint32_t offset) {
+		this->events[this->recorded & (capacity - 1)] = TraceEvent { kind, value, depth, offset };
+		this->recorded++;
+	}
+	void clear();
+	uint64_t get_recorded();
+	size_t size();
+	const TraceEvent& get_event(size_t index);
+	void display(InputPtr input);
+};
+
+// the parser's trace points. when PARSE_TRACE is 0 they are empty,
+// so neither the event nor anything in its arguments is evaluated
+#if PARSE_TRACE
+#define TRACE_EVENT(trace, kind, value, depth, offset) (trace).record(kind, (uint16_t) (value), depth, offset)
+#else
+#define TRACE_EVENT(trace, kind, value, depth, offset) ((void) 0)
+#endif
+
+#endif /* PARSETRACE_HPP_ */
@@ -1,8 +1,18 @@
 #include "Parser.hpp"
 
+// the trace points, at the position of the lookahead
+#define TRACE_RULE(rule) TRACE_EVENT(this->trace, RULE_EVENT, rule, this->parse_depth, \
+									 this->lookahead->get_offset(0))
+#define TRACE_EPSILON() TRACE_EVENT(this->trace, EPSILON_EVENT, 0, this->parse_depth, \
+									this->lookahead->get_offset(0))
+#define TRACE_MATCH(token) TRACE_EVENT(this->trace, MATCH_EVENT, token, this->parse_depth, \
+									   this->lookahead->get_offset(0))
+
 Parser::Parser(ScannerPtr scanner, SemanticAnalyzerPtr analyzer) {
 	this->scanner = scanner;
+	this->lookahead = TokenRingPtr(new TokenRing(scanner->get_input(), lookahead_capacity));
 	this->parse_depth = 0;
+	this->expression_depth = 0;
 	this->error_reported = false;
 	this->analyzer = analyzer;
 	this->symbols = TokenListPtr(new TokenList());
@@ -11,7 +21,7 @@ Parser::Parser(ScannerPtr scanner, SemanticAnalyzerPtr analyzer) {
 }
 
 bool Parser::try_match(TokType expected) {
-	if (this->lookahead->get_token() != expected) {
+	if (this->lookahead_kind() != expected) {
 		return false;
 	} else {
 		return true;
@@ -19,66 +29,83 @@ bool Parser::try_match(TokType expected) {
 }
 
 void Parser::match(TokType expected) {
-	if (this->lookahead->get_token() != expected) {
+	if (this->lookahead_kind() != expected) {
 		// get the error information
 		this->error_reported = true;
 		string expect = get_token_info(expected).first;
-		string received = get_token_info(this->lookahead->get_token()).first;
-		unsigned long line = this->lookahead->get_line();
-		unsigned long column = this->lookahead->get_column();
+		string received = get_token_info(this->lookahead_kind()).first;
+		unsigned long line = this->lookahead->get_line(0);
+		unsigned long column = this->lookahead->get_column(0);
 		// report the error
 		report_error_lc("Parse Error", "Expected "
 						+ expect + " but received '" + received
 						+ "' instead. Fail!", line, column);
 		// catastrophic mode
-		if (this->lookahead->get_token() != TokType::MP_EOF) {
+		if (this->lookahead_kind() != TokType::MP_EOF) {
 			// error checking assumes 'off-by-one'
 			this->populate();
 		}
-		// stop
+		// stop, joining the scan thread first
+		this->pipeline = nullptr;
 		exit(0);
 	} else {
+		// the matched token by value, a shared record is only
+		// built for the places that hold on to one
+		Token record = this->lookahead->get_record(0);
+		TokenPtr lookahead = nullptr;
 		// if we're collecting symbols
 		if (this->sym_collect) {
 			if (this->var_skip == true) {
-				if ((this->lookahead->get_token() != MP_VAR)
-					& (this->lookahead->get_token() == MP_ID
-						|| this->lookahead->get_token() == MP_INTEGER
-						|| this->lookahead->get_token() == MP_FLOAT
-						|| this->lookahead->get_token() == MP_STRING
-						|| this->lookahead->get_token() == MP_BOOLEAN)) {
-					this->symbols->push_back(this->lookahead);
+				if ((this->lookahead_kind() != MP_VAR)
+					& (this->lookahead_kind() == MP_ID
+						|| this->lookahead_kind() == MP_INTEGER
+						|| this->lookahead_kind() == MP_FLOAT
+						|| this->lookahead_kind() == MP_STRING
+						|| this->lookahead_kind() == MP_BOOLEAN)) {
+					lookahead = this->get_token();
+					this->symbols->push_back(lookahead);
 				}
 			} else {
-				if (this->lookahead->get_token() == MP_VAR
-					   || this->lookahead->get_token() == MP_ID
-					   || this->lookahead->get_token() == MP_INTEGER
-					   || this->lookahead->get_token() == MP_FLOAT
-					   || this->lookahead->get_token() == MP_STRING
-					   || this->lookahead->get_token() == MP_BOOLEAN) {
-					this->symbols->push_back(this->lookahead);
+				if (this->lookahead_kind() == MP_VAR
+					   || this->lookahead_kind() == MP_ID
+					   || this->lookahead_kind() == MP_INTEGER
+					   || this->lookahead_kind() == MP_FLOAT
+					   || this->lookahead_kind() == MP_STRING
+					   || this->lookahead_kind() == MP_BOOLEAN) {
+					lookahead = this->get_token();
+					this->symbols->push_back(lookahead);
 				}
 			}
 		}
-		// if we're collecting code generation data...
-		if (!this->gen_collect->empty()) {
+		// if we're collecting code generation data, outside of
+		// an expression, which goes to the code block whole
+		if (!this->gen_collect->empty() && this->expression_depth == 0) {
 			// feed the token to the code block on top of the analyzer
-			this->get_analyzer()->feed_token(this->lookahead);
+			if (lookahead == nullptr) {
+				lookahead = this->get_token();
+			}
+			this->get_analyzer()->feed_token(lookahead);
 		}
 		// add token as a literal to the ast
-		this->create_abstract_node_literal(this->lookahead);
+		this->create_abstract_node_literal(record);
 		this->return_from();
 		// report a match!
-		report_parse("Match: " + get_token_info(expected).first
-					 + ": " + this->lookahead->get_lexeme(), this->parse_depth);
+		TRACE_MATCH(expected);
 		
 		// get the next token from the dispatcher
-		if (this->lookahead->get_token() != TokType::MP_EOF) {
+		if (this->lookahead_kind() != TokType::MP_EOF) {
 			this->populate();
 		}
 	}
 }
 
+TokenPtr Parser::match_token(TokType expected) {
+	// match, keeping a shared record of the token for the caller
+	TokenPtr token = this->get_token();
+	this->match(expected);
+	return token;
+}
+
 void Parser::print_sym_buffer() {
 	// debug the symbol buffer
 	for (auto i = this->symbols->begin(); i != this->symbols->end(); i++) {
@@ -88,37 +115,212 @@ void Parser::print_sym_buffer() {
 }
 
 void Parser::populate() {
-	// scan and populate token buffer
-	this->lookahead = this->scanner->scan_one();
-	// look for irrelevant tokens
-	if (this->lookahead->get_token() == MP_COMMENT
-		|| this->lookahead->get_token() == MP_RUN_COMMENT
-		|| this->lookahead->get_token() == MP_RUN_STRING) {
-		while(this->lookahead->get_token() == MP_COMMENT
-			  || this->lookahead->get_token() == MP_RUN_COMMENT
-			  || this->lookahead->get_token() == MP_RUN_STRING) {
-			this->lookahead = this->scanner->scan_one();
+	// step past the lookahead, the scanner refills the ring in a
+	// batch once it runs dry. comments and run on tokens never make
+	// it in, and the end of file is the last token ever pushed
+	if (!this->lookahead->empty()) {
+		this->lookahead->pop();
+	}
+	if (this->lookahead->empty()) {
+		if (this->pipeline != nullptr) {
+			this->pipeline->take(this->lookahead);
+		} else {
+			this->scanner->refill(*this->lookahead);
 		}
 	}
+	
+	// errors scanned along the way show up as the parser reaches them
+	this->scanner->report_held_errors(*this->lookahead);
+}
+
+TokType Parser::lookahead_kind() {
+	// kind of the current token, straight from the ring
+	return this->lookahead->get_kind(0);
+}
+
+void Parser::set_pipelined(bool pipelined) {
+	// scan on a thread of its own, ahead of the parser, or
+	// interleaved with it. set before parsing starts. this is
+	// opt-in because it is not faster, -n has it at 0.85x to 0.95x
+	// the recursive parser
+	if (pipelined) {
+		this->pipeline = ScanPipelinePtr(new ScanPipeline(this->scanner, lookahead_capacity));
+	} else {
+		this->pipeline = nullptr;
+	}
+}
+
+void Parser::set_table_driven(bool table_driven) {
+	// parse from the grammar's predict table, or by the
+	// recursive parse_* methods. set before parsing starts
+	if (table_driven) {
+		this->grammar = Grammar::get_mikropascal();
+	} else {
+		this->grammar = nullptr;
+	}
 }
 
 void Parser::parse() {
 	// put the next token in the global buffer
 	this->populate();
 	// parse the system goal!
-	this->parse_system_goal();
+	if (this->grammar != nullptr) {
+		this->parse_table_driven();
+	} else {
+		this->parse_system_goal();
+	}
+}
+
+void Parser::parse_table_driven() {
+	// expand rules on an explicit stack, the lookahead picks each
+	// production from the predict table. a rule with a node pushes
+	// an end marker under its symbols to close the node again
+	const Grammar& grammar = *this->grammar;
+	this->parse_stack.clear();
+	this->parse_stack.push_back(GrammarSymbol { NONTERMINAL, SYSTEM_GOAL });
+	while (!this->parse_stack.empty()) {
+		GrammarSymbol symbol = this->parse_stack.back();
+		this->parse_stack.pop_back();
+		switch (symbol.kind) {
+			case TERMINAL:
+				this->match((TokType) symbol.value);
+				break;
+			case ACTION:
+				this->run_action((GrammarAction) symbol.value);
+				break;
+			case RULE_END:
+				this->return_from();
+				this->less_indent();
+				break;
+			case NONTERMINAL: {
+				if (Grammar::get_creates_node(symbol.value)) {
+					this->more_indent();
+					this->create_abstract_node((ParseType) symbol.value);
+					TRACE_RULE(symbol.value);
+					this->parse_stack.push_back(GrammarSymbol { RULE_END, symbol.value });
+				}
+				const Production& production = grammar.get_production(symbol.value, this->lookahead_kind());
+				for (uint32_t i = production.symbol_count; i > 0; i--) {
+					this->parse_stack.push_back(grammar.get_symbol(production.first_symbol + i - 1));
+				}
+				break;
+			}
+		}
+	}
+	this->report_result();
+}
+
+void Parser::run_action(GrammarAction action) {
+	// the same calls the recursive parser makes at this point
+	switch (action) {
+		case BEGIN_DATA_SYMBOL:
+			this->begin_symbol(true);
+			break;
+		case END_DATA_SYMBOL:
+			this->end_symbol(SYM_DATA, NO_CALL);
+			break;
+		case BEGIN_CALLABLE_SYMBOL:
+			this->begin_symbol(false);
+			break;
+		case END_PROCEDURE_SYMBOL:
+			this->end_symbol(SYM_CALLABLE, PROCEDURE);
+			this->analyzer->get_symtable()->go_into();
+			break;
+		case END_FUNCTION_SYMBOL:
+			this->end_symbol(SYM_CALLABLE, FUNCTION);
+			this->analyzer->get_symtable()->go_into();
+			break;
+		case LEAVE_SCOPE:
+			this->analyzer->get_symtable()->return_from();
+			break;
+		case BEGIN_PROGRAM:
+			this->begin_generate_program();
+			break;
+		case SOFT_END_GENERATE:
+			this->soft_end_generate();
+			break;
+		case END_GENERATE:
+			this->end_generate();
+			break;
+		case BEGIN_CALLABLE_PART:
+			this->begin_generate_callable_part(true);
+			break;
+		case BEGIN_PROCEDURE_DEFINITION:
+			this->begin_generate_callable_1(PROCEDURE, DEFINITION);
+			break;
+		case BEGIN_FUNCTION_DEFINITION:
+			this->begin_generate_callable_1(FUNCTION, DEFINITION);
+			break;
+		case BEGIN_PROCEDURE_CALL:
+			this->begin_generate_callable_2(PROCEDURE, CALL);
+			break;
+		case BEGIN_READ:
+			this->begin_generate_io_action(IO_READ, false);
+			break;
+		case BEGIN_READLN:
+			this->begin_generate_io_action(IO_READ, true);
+			break;
+		case BEGIN_WRITE:
+			this->begin_generate_io_action(IO_WRITE, false);
+			break;
+		case BEGIN_WRITELN:
+			this->begin_generate_io_action(IO_WRITE, true);
+			break;
+		case BEGIN_ASSIGNMENT:
+			this->begin_generate_assignment();
+			break;
+		case BEGIN_IF:
+			this->conditionals.push_back(this->begin_generate_if());
+			break;
+		case BEGIN_ELSE: {
+			ConditionalBlockPtr cond_if = this->conditionals.back();
+			ConditionalBlockPtr cond_else = this->begin_generate_opt_else();
+			cond_else->set_connected(cond_if);
+			cond_if->set_connected(cond_else);
+			break;
+		}
+		case END_IF:
+			this->conditionals.pop_back();
+			break;
+		case BEGIN_WHILE:
+			this->begin_generate_loop(WHILELOOP);
+			break;
+		case BEGIN_REPEAT:
+			this->begin_generate_loop(RPTUNTLLOOP);
+			break;
+		case BEGIN_FOR:
+			this->begin_generate_loop(FORLOOP);
+			break;
+		case PARSE_EXPRESSION:
+			this->parse_expression_tree();
+			break;
+		case TYPE_ERROR:
+			report_error("Parse Error", "Syntax is incorrect when matching type.");
+			break;
+		case WEIRD_ERROR:
+			report_msg("Weird...");
+			break;
+		case EOF_ERROR:
+			report_error("Parse Error", "No end-of-file detected.\nMissing newline at end-of-file?");
+			break;
+	}
 }
 
 void Parser::parse_system_goal() {
 	this->more_indent();
 	this->create_abstract_node(SYSTEM_GOAL);
-	report_parse("PARSE_SYSTEM_GOAL", this->parse_depth);
+	TRACE_RULE(SYSTEM_GOAL);
 	// parse program and then reach end of file
 	this->parse_program();
 	this->parse_eof();
 	this->return_from();
 	this->less_indent();
-	
+	this->report_result();
+}
+
+void Parser::report_result() {
+	// the input is parsed, so stop the scan thread
+	this->pipeline = nullptr;
 	// determine if there was an error...
 	if (!this->error_reported) {
 		// report success
@@ -145,7 +347,7 @@ void Parser::produce_code() {
 void Parser::parse_eof() {
 	this->more_indent();
 	this->create_abstract_node(EOF_RULE);
-	report_parse("PARSE_EOF", this->parse_depth);
+	TRACE_RULE(EOF_RULE);
 	
 	// ensure file ends with a newline
 	if (!this->try_match(MP_EOF)) {
@@ -160,7 +362,7 @@ void Parser::parse_eof() {
 void Parser::parse_program() {
 	this->more_indent();
 	this->create_abstract_node(PROGRAM);
-	report_parse("PARSE_PROGRAM", this->parse_depth);
+	TRACE_RULE(PROGRAM);
 	this->parse_program_heading();
 	this->match(MP_SEMI_COLON);
 	this->parse_block();
@@ -172,7 +374,7 @@ void Parser::parse_program() {
 void Parser::parse_block() {
 	this->more_indent();
 	this->create_abstract_node(BLOCK);
-	report_parse("PARSE_BLOCK", this->parse_depth);
+	TRACE_RULE(BLOCK);
 	this->parse_variable_declaration_part();
 	this->begin_generate_callable_part(true);
 	this->parse_procedure_and_function_declaration_part();
@@ -185,7 +387,7 @@ void Parser::parse_block() {
 void Parser::parse_program_heading() {
 	this->more_indent();
 	this->create_abstract_node(PROGRAM_HEADING);
-	report_parse("PARSE_PROGRAM_HEADING", this->parse_depth);
+	TRACE_RULE(PROGRAM_HEADING);
 	this->match(MP_PROGRAM);
 	this->begin_generate_program();
 	this->parse_program_identifier();
@@ -197,7 +399,7 @@ void Parser::parse_program_heading() {
 void Parser::parse_variable_declaration_part() {
 	this->more_indent();
 	this->create_abstract_node(VARIABLE_DECL_PART);
-	report_parse("PARSE_VARIABLE_DECLARATION_PART", this->parse_depth);
+	TRACE_RULE(VARIABLE_DECL_PART);
 	// is an identifier clause
 	if (this->try_match(MP_VAR)) {
 		this->match(MP_VAR);
@@ -206,7 +408,7 @@ void Parser::parse_variable_declaration_part() {
 		this->parse_variable_declaration_tail();
 	} else {
 		// or matches epsilon
-		report_parse("EPSILON_MATCHED", this->parse_depth);
+		TRACE_EPSILON();
 		this->create_abstract_node(EPSILON);
 		this->return_from();
 	}
@@ -217,7 +419,7 @@ void Parser::parse_variable_declaration_part() {
 void Parser::parse_variable_declaration_tail() {
 	this->more_indent();
 	this->create_abstract_node(VARIABLE_DECL_TAIL);
-	report_parse("PARSE_VARIABLE_DECL_TAIL", this->parse_depth);
+	TRACE_RULE(VARIABLE_DECL_TAIL);
 	if (this->try_match(MP_ID)) {
 		this->parse_variable_declaration();
 		this->match(MP_SEMI_COLON);
@@ -225,7 +427,7 @@ void Parser::parse_variable_declaration_tail() {
 		this->parse_variable_declaration_tail();
 	} else {
 		// or epsilon
-		report_parse("EPSILON_MATCHED", this->parse_depth);
+		TRACE_EPSILON();
 		this->create_abstract_node(EPSILON);
 		this->return_from();
 	}
@@ -237,7 +439,7 @@ void Parser::parse_variable_declaration() {
 	this->more_indent();
 	this->create_abstract_node(VARIABLE_DECL);
 	this->begin_symbol(true);
-	report_parse("PARSE_VARIABLE_DECL", this->parse_depth);
+	TRACE_RULE(VARIABLE_DECL);
 	this->parse_identifier_list();
 	this->match(MP_COLON);
 	this->parse_type();
@@ -249,7 +451,7 @@ void Parser::parse_variable_declaration() {
 void Parser::parse_type() {
 	this->more_indent();
 	this->create_abstract_node(TYPE);
-	report_parse("PARSE_TYPE", this->parse_depth);
+	TRACE_RULE(TYPE);
 	if (try_match(MP_INTEGER)) {
 		this->match(MP_INTEGER);
 	} else if (try_match(MP_FLOAT)) {
@@ -269,7 +471,7 @@ void Parser::parse_type() {
 void Parser::parse_procedure_and_function_declaration_part() {
 	this->more_indent();
 	this->create_abstract_node(PROCEDURE_AND_FUNCTION_DECL_PART);
-	report_parse("PARSE_PROCEDURE_AND_FUNCTION_DECL_PART", this->parse_depth);
+	TRACE_RULE(PROCEDURE_AND_FUNCTION_DECL_PART);
 	if (this->try_match(MP_PROCEDURE)) {
 		this->parse_procedure_declaration();
 		this->parse_procedure_and_function_declaration_part();
@@ -278,7 +480,7 @@ void Parser::parse_procedure_and_function_declaration_part() {
 		this->parse_procedure_and_function_declaration_part();
 	} else {
 		// or epsilon
-		report_parse("EPSILON_MATCHED", this->parse_depth);
+		TRACE_EPSILON();
 	}
 	this->return_from();
 	this->less_indent();
@@ -287,7 +489,7 @@ void Parser::parse_procedure_and_function_declaration_part() {
 void Parser::parse_procedure_declaration() {
 	this->more_indent();
 	this->create_abstract_node(PROCEDURE_DECL);
-	report_parse("PARSE_PROCEDURE_DECL", this->parse_depth);
+	TRACE_RULE(PROCEDURE_DECL);
 	this->parse_procedure_heading();
 	this->match(MP_SEMI_COLON);
 	this->begin_generate_callable_1(PROCEDURE, DEFINITION);
@@ -302,7 +504,7 @@ void Parser::parse_procedure_declaration() {
 void Parser::parse_function_declaration() {
 	this->more_indent();
 	this->create_abstract_node(FUNCTION_DECL);
-	report_parse("PARSE_FUNCTION_DECL", this->parse_depth);
+	TRACE_RULE(FUNCTION_DECL);
 	this->parse_function_heading();
 	this->match(MP_SEMI_COLON);
 	this->begin_generate_callable_1(FUNCTION, DEFINITION);
@@ -318,7 +520,7 @@ void Parser::parse_procedure_heading() {
 	this->more_indent();
 	this->create_abstract_node(PROCEDURE_HEAD);
 	this->begin_symbol(false);
-	report_parse("PARSE_PROCEDURE_HEADING", this->parse_depth);
+	TRACE_RULE(PROCEDURE_HEAD);
 	this->match(MP_PROCEDURE);
 	this->parse_procedure_identifier();
 	this->parse_optional_formal_parameter_list();
@@ -332,7 +534,7 @@ void Parser::parse_function_heading() {
 	this->more_indent();
 	this->create_abstract_node(FUNCTION_HEAD);
 	this->begin_symbol(false);
-	report_parse("PARSE_FUNCTION_HEADING", this->parse_depth);
+	TRACE_RULE(FUNCTION_HEAD);
 	this->match(MP_FUNCTION);
 	this->parse_function_identifier();
 	this->parse_optional_formal_parameter_list();
@@ -347,7 +549,7 @@ void Parser::parse_function_heading() {
 void Parser::parse_optional_formal_parameter_list() {
 	this->more_indent();
 	this->create_abstract_node(OPT_FORMAL_PARAM_LIST);
-	report_parse("PARSE_OPT_FORMAL_PARAM_LIST", this->parse_depth);
+	TRACE_RULE(OPT_FORMAL_PARAM_LIST);
 	if (this->try_match(MP_LEFT_PAREN)) {
 		this->match(MP_LEFT_PAREN);
 		this->parse_formal_parameter_section();
@@ -355,7 +557,7 @@ void Parser::parse_optional_formal_parameter_list() {
 		this->match(MP_RIGHT_PAREN);
 	} else {
 		// or match epsilon
-		report_parse("EPSILON_MATCHED", this->parse_depth);
+		TRACE_EPSILON();
 		this->create_abstract_node(EPSILON);
 		this->return_from();
 	}
@@ -366,14 +568,14 @@ void Parser::parse_optional_formal_parameter_list() {
 void Parser::parse_formal_parameter_section_tail() {
 	this->more_indent();
 	this->create_abstract_node(FORMAL_PARAM_SECTION_TAIL);
-	report_parse("PARSE_FORMAL_PARAM_SECTION_TAIL", this->parse_depth);
+	TRACE_RULE(FORMAL_PARAM_SECTION_TAIL);
 	if (this->try_match(MP_SEMI_COLON)) {
 		this->match(MP_SEMI_COLON);
 		this->parse_formal_parameter_section();
 		this->parse_formal_parameter_section_tail();
 	} else {
 		// or match epsilon
-		report_parse("EPSILON_MATCHED", this->parse_depth);
+		TRACE_EPSILON();
 		this->create_abstract_node(EPSILON);
 		this->return_from();
 	}
@@ -384,7 +586,7 @@ void Parser::parse_formal_parameter_section_tail() {
 void Parser::parse_formal_parameter_section() {
 	this->more_indent();
 	this->create_abstract_node(FORMAL_PARAM);
-	report_parse("PARSE_FORMAL_PARAM_SECTION", this->parse_depth);
+	TRACE_RULE(FORMAL_PARAM);
 	if (this->try_match(MP_ID)) {
 		this->parse_value_parameter_section();
 	} else if (this->try_match(MP_VAR)) {
@@ -397,7 +599,7 @@ void Parser::parse_formal_parameter_section() {
 void Parser::parse_value_parameter_section() {
 	this->more_indent();
 	this->create_abstract_node(VALUE_PARAM_SECTION);
-	report_parse("PARSE_VAL_PARAM_SECTION", this->parse_depth);
+	TRACE_RULE(VALUE_PARAM_SECTION);
 	this->parse_identifier_list();
 	this->match(MP_COLON);
 	this->parse_type();
@@ -408,7 +610,7 @@ void Parser::parse_value_parameter_section() {
 void Parser::parse_variable_parameter_section() {
 	this->more_indent();
 	this->create_abstract_node(VARIABLE_PARAM_SECTION);
-	report_parse("PARSE_VAL_PARAM_SECTION", this->parse_depth);
+	TRACE_RULE(VARIABLE_PARAM_SECTION);
 	this->match(MP_VAR);
 	this->parse_identifier_list();
 	this->match(MP_COLON);
@@ -420,7 +622,7 @@ void Parser::parse_variable_parameter_section() {
 void Parser::parse_statement_part() {
 	this->more_indent();
 	this->create_abstract_node(STATEMENT_PART);
-	report_parse("PARSE_STATEMENT_PART", this->parse_depth);
+	TRACE_RULE(STATEMENT_PART);
 	this->parse_compound_statement();
 	this->return_from();
 	this->less_indent();
@@ -429,7 +631,7 @@ void Parser::parse_statement_part() {
 void Parser::parse_compound_statement() {
 	this->more_indent();
 	this->create_abstract_node(COMPOUND_STATEMENT);
-	report_parse("PARSE_COMPOUND_STATEMENT", this->parse_depth);
+	TRACE_RULE(COMPOUND_STATEMENT);
 	this->match(MP_BEGIN);
 	this->parse_statement_sequence();
 	this->match(MP_END);
@@ -440,7 +642,7 @@ void Parser::parse_compound_statement() {
 void Parser::parse_statement_sequence() {
 	this->more_indent();
 	this->create_abstract_node(STATEMENT_SEQUENCE);
-	report_parse("PARSE_STATEMENT_SEQUENCE", this->parse_depth);
+	TRACE_RULE(STATEMENT_SEQUENCE);
 	this->parse_statement();
 	this->parse_statement_tail();
 	this->return_from();
@@ -450,14 +652,14 @@ void Parser::parse_statement_sequence() {
 void Parser::parse_statement_tail() {
 	this->more_indent();
 	this->create_abstract_node(STATEMENT_TAIL);
-	report_parse("PARSE_STATEMENT_TAIL", this->parse_depth);
+	TRACE_RULE(STATEMENT_TAIL);
 	if (this->try_match(MP_SEMI_COLON)) {
 		this->match(MP_SEMI_COLON);
 		this->parse_statement();
 		this->parse_statement_tail();
 	} else {
 		// or match epsilon
-		report_parse("EPSILON_MATCHED", this->parse_depth);
+		TRACE_EPSILON();
 		this->create_abstract_node(EPSILON);
 		this->return_from();
 	}
@@ -468,7 +670,7 @@ void Parser::parse_statement_tail() {
 void Parser::parse_statement() {
 	this->more_indent();
 	this->create_abstract_node(STATEMENT);
-	report_parse("PARSE_STATEMENT", this->parse_depth);
+	TRACE_RULE(STATEMENT);
 	// try matching to all statement types
 	if (this->try_match(MP_READ)) {
 		this->begin_generate_io_action(IO_READ, false);
@@ -476,7 +678,7 @@ void Parser::parse_statement() {
 		this->end_generate();
 	}
 	else if (this->try_match(MP_READLN)) {
-		this->begin_generate_io_action(IO_WRITE, true);
+		this->begin_generate_io_action(IO_READ, true);
 		this->parse_read_statement();
 		this->end_generate();
 	}
@@ -531,7 +733,7 @@ void Parser::parse_statement() {
 void Parser::parse_empty_statement() {
 	this->more_indent();
 	this->create_abstract_node(EMPTY_STATEMENT);
-	report_parse("PARSE_EMPTY_STATEMENT", this->parse_depth);
+	TRACE_RULE(EMPTY_STATEMENT);
 	this->return_from();
 	this->less_indent();
 }
@@ -539,7 +741,7 @@ void Parser::parse_empty_statement() {
 void Parser::parse_read_statement() {
 	this->more_indent();
 	this->create_abstract_node(READ_STATEMENT);
-	report_parse("PARSE_READ_STATEMENT", this->parse_depth);
+	TRACE_RULE(READ_STATEMENT);
 	if (this->try_match(MP_READ)) {
 		this->match(MP_READ);
 	}
@@ -557,14 +759,14 @@ void Parser::parse_read_statement() {
 void Parser::parse_read_parameter_tail() {
 	this->more_indent();
 	this->create_abstract_node(READ_PARAMETER_TAIL);
-	report_parse("PARSE_READ_PARAM_TAIL", this->parse_depth);
+	TRACE_RULE(READ_PARAMETER_TAIL);
 	if (this->try_match(MP_COMMA)) {
 		this->match(MP_COMMA);
 		this->parse_read_parameter();
 		this->parse_read_parameter_tail();
 	} else {
 		// matched epsilon
-		report_parse("EPSILON_MATCHED", this->parse_depth);
+		TRACE_EPSILON();
 		this->create_abstract_node(EPSILON);
 		this->return_from();
 	}
@@ -575,7 +777,7 @@ void Parser::parse_read_parameter_tail() {
 void Parser::parse_read_parameter() {
 	this->more_indent();
 	this->create_abstract_node(READ_PARAMETER);
-	report_parse("PARSE_READ_PARAM", this->parse_depth);
+	TRACE_RULE(READ_PARAMETER);
 	this->parse_variable_identifier();
 	this->return_from();
 	this->less_indent();
@@ -584,7 +786,7 @@ void Parser::parse_read_parameter() {
 void Parser::parse_write_statement() {
 	this->more_indent();
 	this->create_abstract_node(WRITE_STATEMENT);
-	report_parse("PARSE_WRITE_STATEMENT", this->parse_depth);
+	TRACE_RULE(WRITE_STATEMENT);
 	if (this->try_match(MP_WRITELN)) {
 		this->match(MP_WRITELN);
 	} else if (this->try_match(MP_WRITE)) {
@@ -601,14 +803,14 @@ void Parser::parse_write_statement() {
 void Parser::parse_write_parameter_tail() {
 	this->more_indent();
 	this->create_abstract_node(WRITE_PARAMETER_TAIL);
-	report_parse("PARSE_WRITE_PARAM_TAIL", this->parse_depth);
+	TRACE_RULE(WRITE_PARAMETER_TAIL);
 	if (this->try_match(MP_COMMA)) {
 		this->match(MP_COMMA);
 		this->parse_write_parameter();
 		this->parse_write_parameter_tail();
 	} else {
 		// matched epsilon
-		report_parse("EPSILON_MATCHED", this->parse_depth);
+		TRACE_EPSILON();
 		this->create_abstract_node(EPSILON);
 		this->return_from();
 	}
@@ -619,7 +821,7 @@ void Parser::parse_write_parameter_tail() {
 void Parser::parse_write_parameter() {
 	this->more_indent();
 	this->create_abstract_node(WRITE_PARAMETER);
-	report_parse("PARSE_WRITE_PARAM", this->parse_depth);
+	TRACE_RULE(WRITE_PARAMETER);
 	this->parse_ordinal_expression();
 	this->return_from();
 	this->less_indent();
@@ -628,7 +830,7 @@ void Parser::parse_write_parameter() {
 void Parser::parse_assignment_statement() {
 	this->more_indent();
 	this->create_abstract_node(ASSIGNMENT_STATEMENT);
-	report_parse("PARSE_ASSIGN_STATEMENT", this->parse_depth);
+	TRACE_RULE(ASSIGNMENT_STATEMENT);
 	this->parse_variable_identifier();
 	this->match(MP_ASSIGNMENT);
 	this->parse_expression();
@@ -639,7 +841,7 @@ void Parser::parse_assignment_statement() {
 void Parser::parse_if_statement() {
 	this->more_indent();
 	this->create_abstract_node(IF_STATEMENT);
-	report_parse("PARSE_IF_STATEMENT", this->parse_depth);
+	TRACE_RULE(IF_STATEMENT);
 	ConditionalBlockPtr cond_if = this->begin_generate_if();
 	this->match(MP_IF);
 	this->parse_boolean_expression();
@@ -660,14 +862,14 @@ void Parser::parse_if_statement() {
 void Parser::parse_optional_else_part() {
 	this->more_indent();
 	this->create_abstract_node(OPTIONAL_ELSE_PART);
-	report_parse("PARSE_OPTIONAL_ELSE_PART", this->parse_depth);
+	TRACE_RULE(OPTIONAL_ELSE_PART);
 	if (this->try_match(MP_ELSE)) {
 		// we have an else part
 		this->match(MP_ELSE);
 		this->parse_statement();
 	} else {
 		// or epsilon
-		report_parse("EPSILON_REACHED", this->parse_depth);
+		TRACE_EPSILON();
 		this->create_abstract_node(EPSILON);
 		this->return_from();
 	}
@@ -678,7 +880,7 @@ void Parser::parse_optional_else_part() {
 void Parser::parse_repeat_statement() {
 	this->more_indent();
 	this->create_abstract_node(REPEAT_STATEMENT);
-	report_parse("PARSE_REPEAT_STATEMENT", this->parse_depth);
+	TRACE_RULE(REPEAT_STATEMENT);
 	this->match(MP_REPEAT);
 	this->parse_statement_sequence();
 	this->match(MP_UNTIL);
@@ -690,7 +892,7 @@ void Parser::parse_repeat_statement() {
 void Parser::parse_while_statement() {
 	this->more_indent();
 	this->create_abstract_node(WHILE_STATEMENT);
-	report_parse("PARSE_WHILE_STATEMENT", this->parse_depth);
+	TRACE_RULE(WHILE_STATEMENT);
 	this->match(MP_WHILE);
 	this->parse_boolean_expression();
 	this->match(MP_DO);
@@ -702,7 +904,7 @@ void Parser::parse_while_statement() {
 void Parser::parse_for_statement() {
 	this->more_indent();
 	this->create_abstract_node(FOR_STATEMENT);
-	report_parse("PARSE_FOR_STATEMENT", this->parse_depth);
+	TRACE_RULE(FOR_STATEMENT);
 	this->match(MP_FOR);
 	this->parse_control_variable();
 	this->match(MP_ASSIGNMENT);
@@ -718,7 +920,7 @@ void Parser::parse_for_statement() {
 void Parser::parse_control_variable() {
 	this->more_indent();
 	this->create_abstract_node(CONTROL_VARIABLE);
-	report_parse("PARSE_CONTROL_VARIABLE", this->parse_depth);
+	TRACE_RULE(CONTROL_VARIABLE);
 	this->parse_variable_identifier();
 	this->return_from();
 	this->less_indent();
@@ -727,7 +929,7 @@ void Parser::parse_control_variable() {
 void Parser::parse_initial_value() {
 	this->more_indent();
 	this->create_abstract_node(INITIAL_VALUE);
-	report_parse("PARSE_INITIAL_VALUE", this->parse_depth);
+	TRACE_RULE(INITIAL_VALUE);
 	this->parse_ordinal_expression();
 	this->return_from();
 	this->less_indent();
@@ -736,7 +938,7 @@ void Parser::parse_initial_value() {
 void Parser::parse_step_value() {
 	this->more_indent();
 	this->create_abstract_node(STEP_VALUE);
-	report_parse("PARSE_STEP_VALUE", this->parse_depth);
+	TRACE_RULE(STEP_VALUE);
 	if (this->try_match(MP_TO)) {
 		this->match(MP_TO);
 	} else if (this->try_match(MP_DOWNTO)) {
@@ -752,7 +954,7 @@ void Parser::parse_step_value() {
 void Parser::parse_final_value() {
 	this->more_indent();
 	this->create_abstract_node(FINAL_VALUE);
-	report_parse("PARSE_FINAL_VALUE", this->parse_depth);
+	TRACE_RULE(FINAL_VALUE);
 	this->parse_ordinal_expression();
 	this->return_from();
 	this->less_indent();
@@ -761,7 +963,7 @@ void Parser::parse_final_value() {
 void Parser::parse_procedure_statement() {
 	this->more_indent();
 	this->create_abstract_node(PROCEDURE_STATEMENT);
-	report_parse("PARSE_PROCEDURE_STATEMENT", this->parse_depth);
+	TRACE_RULE(PROCEDURE_STATEMENT);
 	this->parse_procedure_identifier();
 	this->parse_optional_actual_parameter_list();
 	this->return_from();
@@ -771,7 +973,7 @@ void Parser::parse_procedure_statement() {
 void Parser::parse_optional_actual_parameter_list() {
 	this->more_indent();
 	this->create_abstract_node(OPTIONAL_ACTUAL_PARAMETER_LIST);
-	report_parse("PARSE_OPTIONAL_ACTUAL_PARAM_LIST", this->parse_depth);
+	TRACE_RULE(OPTIONAL_ACTUAL_PARAMETER_LIST);
 	if (this->try_match(MP_LEFT_PAREN)) {
 		// optional list used
 		this->match(MP_LEFT_PAREN);
@@ -779,7 +981,7 @@ void Parser::parse_optional_actual_parameter_list() {
 		this->parse_actual_parameter_tail();
 	} else {
 		// epsilon
-		report_parse("EPSILON_REACHED", this->parse_depth);
+		TRACE_EPSILON();
 		this->create_abstract_node(EPSILON);
 		this->return_from();
 	}
@@ -790,14 +992,14 @@ void Parser::parse_optional_actual_parameter_list() {
 void Parser::parse_actual_parameter_tail() {
 	this->more_indent();
 	this->create_abstract_node(ACTUAL_PARAMETER_TAIL);
-	report_parse("PARSE_ACTUAL_PARAM_TAIL", this->parse_depth);
+	TRACE_RULE(ACTUAL_PARAMETER_TAIL);
 	if (this->try_match(MP_COMMA)) {
 		// param tail used
 		this->parse_actual_parameter();
 		this->parse_actual_parameter_tail();
 	} else {
 		// epsilon used
-		report_parse("EPSILON_REACHED", this->parse_depth);
+		TRACE_EPSILON();
 		this->create_abstract_node(EPSILON);
 		this->return_from();
 	}
@@ -808,7 +1010,7 @@ void Parser::parse_actual_parameter_tail() {
 void Parser::parse_actual_parameter() {
 	this->more_indent();
 	this->create_abstract_node(ACTUAL_PARAMETER);
-	report_parse("PARSE_ACTUAL_PARAM", this->parse_depth);
+	TRACE_RULE(ACTUAL_PARAMETER);
 	this->parse_ordinal_expression();
 	this->return_from();
 	this->less_indent();
@@ -817,205 +1019,118 @@ void Parser::parse_actual_parameter() {
 void Parser::parse_expression() {
 	this->more_indent();
 	this->create_abstract_node(EXPRESSION);
-	report_parse("PARSE_EXPRESSION", this->parse_depth);
-	this->parse_simple_expression();
-	this->parse_optional_relational_part();
-	this->return_from();
-	this->less_indent();
-}
-
-void Parser::parse_optional_relational_part() {
-	this->more_indent();
-	this->create_abstract_node(OPTIONAL_RELATIONAL_PART);
-	report_parse("PARSE_OPTIONAL_RELATIONAL_PART", this->parse_depth);
-	if (this->is_relational_operator()) {
-		this->parse_relational_operator();
-		this->parse_simple_expression();
-	} else {
-		// epsilon
-		report_parse("EPSILON_REACHED", this->parse_depth);
-		this->create_abstract_node(EPSILON);
-		this->return_from();
-	}
-	this->return_from();
-	this->less_indent();
-}
-
-void Parser::parse_relational_operator() {
-	this->more_indent();
-	this->create_abstract_node(RELATIONAL_OPERATOR);
-	report_parse("PARSE_RELATIONAL_OPERATOR", this->parse_depth);
-	if (this->try_match(MP_EQUALS))
-		this->match(MP_EQUALS);
-	else if (this->try_match(MP_LESSTHAN))
-		this->match(MP_LESSTHAN);
-	else if (this->try_match(MP_GREATERTHAN))
-		this->match(MP_GREATERTHAN);
-	else if (this->try_match(MP_GREATERTHAN_EQUALTO))
-		this->match(MP_GREATERTHAN_EQUALTO);
-	else if (this->try_match(MP_LESSTHAN_EQUALTO))
-		this->match(MP_LESSTHAN_EQUALTO);
-	else if (this->try_match(MP_NOT_EQUAL))
-		this->match(MP_NOT_EQUAL);
-	else {
-		report_msg("Weird...");
-	}
-	this->return_from();
-	this->less_indent();
-}
-
-void Parser::parse_simple_expression() {
-	this->more_indent();
-	this->create_abstract_node(SIMPLE_EXPRESSION);
-	report_parse("PARSE_SIMPLE_EXPR", this->parse_depth);
-	this->parse_optional_sign();
-	this->parse_term();
-	this->parse_term_tail();
-	this->return_from();
-	this->less_indent();
-}
-
-void Parser::parse_optional_sign() {
-	this->more_indent();
-	this->create_abstract_node(OPTIONAL_SIGN);
-	report_parse("PARSE_OPT_SIGN", this->parse_depth);
-	if (this->try_match(MP_PLUS))  {
-		this->get_analyzer()->feed_token(TokenPtr(new Token(MP_INT_LITERAL, "0", -1, -1)));
-		this->match(MP_PLUS);
-	} else if (this->try_match(MP_MINUS)) {
-		this->get_analyzer()->feed_token(TokenPtr(new Token(MP_INT_LITERAL, "0", -1, -1)));
-		this->match(MP_MINUS);
-	} else {
-		// no optional sign, epsilon
-		report_parse("EPSILON_REACHED", this->parse_depth);
-		this->create_abstract_node(EPSILON);
-		this->return_from();
-	}
+	TRACE_RULE(EXPRESSION);
+	this->parse_expression_tree();
 	this->return_from();
 	this->less_indent();
 }
 
-void Parser::parse_adding_operator() {
-	this->more_indent();
-	this->create_abstract_node(ADDING_OPERATOR);
-	report_parse("PARSE_ADDING_OP", this->parse_depth);
-	if (this->try_match(MP_PLUS))
-		this->match(MP_PLUS);
-	else if (this->try_match(MP_MINUS))
-		this->match(MP_MINUS);
-	else if (this->try_match(MP_OR))
-		this->match(MP_OR);
-	else {
-		// syntax error!!!!!
-		report_error("Parse Error", "Invalid operator");
+void Parser::parse_expression_tree() {
+	// build the expression in one pass of precedence climbing.
+	// its tokens stay out of the code block, which is handed
+	// the finished tree instead
+	ExpressionPtr expression = ExpressionPtr(new Expression());
+	this->expression_depth++;
+	this->parse_precedence(*expression, RELATIONAL_POWER);
+	this->expression_depth--;
+	// parameters of a function call belong to the outer expression
+	if (this->expression_depth == 0 && !this->gen_collect->empty()) {
+		this->get_analyzer()->feed_expression(expression);
 	}
-	this->return_from();
-	this->less_indent();
 }
 
-void Parser::parse_term_tail() {
-	this->more_indent();
-	this->create_abstract_node(TERM_TAIL);
-	report_parse("PARSE_TERM_TAIL", this->parse_depth);
-	if (this->is_adding_operator()) {
-		this->parse_adding_operator();
-		this->parse_term();
-		this->parse_term_tail();
+AbstractIndex Parser::parse_precedence(Expression& expression, unsigned int min_power) {
+	AbstractIndex left = AbstractNode::no_node;
+	TokType sign = this->lookahead_kind();
+	if (min_power <= ADDING_POWER && (sign == MP_PLUS || sign == MP_MINUS)) {
+		// a simple expression may lead with a sign,
+		// taken as 0 + or 0 - its first term
+		AbstractIndex zero = expression.add_operand(TokenPtr(new Token(MP_INT_LITERAL, "0", -1, -1)));
+		TokenPtr op = this->match_token(sign);
+		AbstractIndex term = this->parse_precedence(expression, MULTIPLYING_POWER);
+		left = expression.add_binary(op, zero, term);
 	} else {
-		// epsilon
-		report_parse("EPSILON_REACHED", this->parse_depth);
-		this->create_abstract_node(EPSILON);
-		this->return_from();
+		left = this->parse_operand(expression);
 	}
-	this->return_from();
-	this->less_indent();
-}
-
-void Parser::parse_term() {
-	this->more_indent();
-	this->create_abstract_node(TERM);
-	report_parse("PARSE_TERM", this->parse_depth);
-	this->parse_factor();
-	this->parse_factor_tail();
-	this->return_from();
-	this->less_indent();
-}
-
-void Parser::parse_factor_tail() {
-	this->more_indent();
-	this->create_abstract_node(FACTOR_TAIL);
-	report_parse("PARSE_FACTOR_TAIL", this->parse_depth);
-	if (this->is_multiplying_operator()) {
-		this->parse_multiplying_operator();
-		this->parse_factor();
-		this->parse_factor_tail();
-	} else {
-		// epsilon
-		report_parse("EPSILON_REACHED", this->parse_depth);
-		this->create_abstract_node(EPSILON);
-		this->return_from();
+	// take operators binding at least as tightly as min_power. their
+	// right operands only take tighter ones, so each level is left
+	// associative
+	unsigned int power = get_binding_power(this->lookahead_kind());
+	while (power != NO_POWER && power >= min_power) {
+		TokenPtr op = this->match_token(this->lookahead_kind());
+		AbstractIndex right = this->parse_precedence(expression, power + 1);
+		left = expression.add_binary(op, left, right);
+		if (power == RELATIONAL_POWER) {
+			// comparisons don't chain
+			break;
+		}
+		power = get_binding_power(this->lookahead_kind());
 	}
-	this->return_from();
-	this->less_indent();
+	return left;
 }
 
-void Parser::parse_multiplying_operator() {
-	this->more_indent();
-	this->create_abstract_node(MULTIPLYING_OPERATOR);
-	report_parse("PARSE_MULTIPLYING_OP", this->parse_depth);
-	if (this->try_match(MP_MULT))
-		this->match(MP_MULT);
-	else if (this->try_match(MP_DIV))
-		this->match(MP_DIV);
-	else if (this->try_match(MP_AND))
-		this->match(MP_AND);
-	else if (this->try_match(MP_MOD_KW))
-		this->match(MP_MOD_KW);
-	else if (this->try_match(MP_DIV_KW))
-		this->match(MP_DIV_KW);
-	else {
-		// syntax error!!!!!
-		report_error("Parse Error", "Yuck, no operator reached...");
+AbstractIndex Parser::parse_operand(Expression& expression) {
+	switch (this->lookahead_kind()) {
+		case MP_LEFT_PAREN: {
+			// assume an expression
+			this->match(MP_LEFT_PAREN);
+			AbstractIndex inner = this->parse_precedence(expression, RELATIONAL_POWER);
+			this->match(MP_RIGHT_PAREN);
+			return inner;
+		}
+		case MP_INT_LITERAL:
+		case MP_FLOAT_LITERAL:
+		case MP_STRING_LITERAL:
+		case MP_TRUE:
+		case MP_FALSE:
+			return expression.add_operand(this->match_token(this->lookahead_kind()));
+		case MP_NOT: {
+			TokenPtr op = this->match_token(MP_NOT);
+			AbstractIndex operand = this->parse_operand(expression);
+			return expression.add_unary(op, operand);
+		}
+		default: {
+			// would have expected a function identifier anyways
+			AbstractIndex operand = expression.add_operand(this->match_token(MP_ID));
+			if (this->try_match(MP_LEFT_PAREN)) {
+				// calls generate no code yet, the parameters
+				// are parsed but only the identifier is kept
+				this->parse_optional_actual_parameter_list();
+			}
+			return operand;
+		}
 	}
-	this->return_from();
-	this->less_indent();
 }
 
-void Parser::parse_factor() {
-	this->more_indent();
-	this->create_abstract_node(FACTOR);
-	report_parse("PARSE_FACTOR", this->parse_depth);
-	if (this->try_match(MP_LEFT_PAREN)) {
-		// assume an expression
-		this->match(MP_LEFT_PAREN);
-		this->parse_expression();
-		this->match(MP_RIGHT_PAREN);
-	} else if (this->try_match(MP_INT_LITERAL)) {
-		this->match(MP_INT_LITERAL);
-	} else if (this->try_match(MP_FLOAT_LITERAL)) {
-		this->match(MP_FLOAT_LITERAL);
-	} else if (this->try_match(MP_STRING_LITERAL)) {
-		this->match(MP_STRING_LITERAL);
-	} else if (this->try_match(MP_TRUE)) {
-		this->match(MP_TRUE);
-	} else if (this->try_match(MP_FALSE)) {
-		this->match(MP_FALSE);
-	} else if (this->try_match(MP_NOT)) {
-		this->match(MP_NOT);
-		this->parse_factor();
-	} else {
-		// would have expected a function identifier anyways
-		this->parse_function_identifier();
-		this->parse_optional_actual_parameter_list();
+unsigned int Parser::get_binding_power(TokType token) {
+	// how tightly an infix operator holds its operands
+	switch (token) {
+		case MP_EQUALS:
+		case MP_LESSTHAN:
+		case MP_GREATERTHAN:
+		case MP_GREATERTHAN_EQUALTO:
+		case MP_LESSTHAN_EQUALTO:
+		case MP_NOT_EQUAL:
+			return RELATIONAL_POWER;
+		case MP_PLUS:
+		case MP_MINUS:
+		case MP_OR:
+			return ADDING_POWER;
+		case MP_MULT:
+		case MP_DIV:
+		case MP_DIV_KW:
+		case MP_MOD_KW:
+		case MP_AND:
+			return MULTIPLYING_POWER;
+		default:
+			return NO_POWER;
 	}
-	this->return_from();
-	this->less_indent();
 }
 
 void Parser::parse_program_identifier() {
 	this->more_indent();
 	this->create_abstract_node(PROGRAM_IDENTIFIER);
-	report_parse("PARSE_PROGRAM_IDENTIFIER", this->parse_depth);
+	TRACE_RULE(PROGRAM_IDENTIFIER);
 	this->parse_identifier();
 	this->return_from();
 	this->less_indent();
@@ -1024,7 +1139,7 @@ void Parser::parse_program_identifier() {
 void Parser::parse_variable_identifier() {
 	this->more_indent();
 	this->create_abstract_node(VARIABLE_IDENTIFIER);
-	report_parse("PARSE_VARIABLE_IDENTIFIER", this->parse_depth);
+	TRACE_RULE(VARIABLE_IDENTIFIER);
 	this->parse_identifier();
 	this->return_from();
 	this->less_indent();
@@ -1033,7 +1148,7 @@ void Parser::parse_variable_identifier() {
 void Parser::parse_procedure_identifier() {
 	this->more_indent();
 	this->create_abstract_node(PROCEDURE_IDENTIFIER);
-	report_parse("PARSE_PROCEDURE_IDENTIFIER", this->parse_depth);
+	TRACE_RULE(PROCEDURE_IDENTIFIER);
 	this->parse_identifier();
 	this->return_from();
 	this->less_indent();
@@ -1042,7 +1157,7 @@ void Parser::parse_procedure_identifier() {
 void Parser::parse_function_identifier() {
 	this->more_indent();
 	this->create_abstract_node(FUNCTION_IDENTFIER);
-	report_parse("PARSE_FUNCTION_IDENTIFIER", this->parse_depth);
+	TRACE_RULE(FUNCTION_IDENTFIER);
 	this->parse_identifier();
 	this->return_from();
 	this->less_indent();
@@ -1051,7 +1166,7 @@ void Parser::parse_function_identifier() {
 void Parser::parse_boolean_expression() {
 	this->more_indent();
 	this->create_abstract_node(BOOLEAN_EXPRESSION);
-	report_parse("PARSE_BOOLEAN_EXPRESSION", this->parse_depth);
+	TRACE_RULE(BOOLEAN_EXPRESSION);
 	this->parse_expression();
 	this->return_from();
 	this->less_indent();
@@ -1060,7 +1175,7 @@ void Parser::parse_boolean_expression() {
 void Parser::parse_ordinal_expression() {
 	this->more_indent();
 	this->create_abstract_node(ORDINAL_EXPRESSION);
-	report_parse("PARSE_ORDINAL_EXPRESSION", this->parse_depth);
+	TRACE_RULE(ORDINAL_EXPRESSION);
 	this->parse_expression();
 	this->return_from();
 	this->less_indent();
@@ -1069,7 +1184,7 @@ void Parser::parse_ordinal_expression() {
 void Parser::parse_identifier_list() {
 	this->more_indent();
 	this->create_abstract_node(IDENTFIER_LIST);
-	report_parse("PARSE_IDENTIFIER_LIST", this->parse_depth);
+	TRACE_RULE(IDENTFIER_LIST);
 	this->parse_identifier();
 	this->parse_identifier_tail();
 	this->return_from();
@@ -1079,14 +1194,14 @@ void Parser::parse_identifier_list() {
 void Parser::parse_identifier_tail() {
 	this->more_indent();
 	this->create_abstract_node(IDENTFIER_TAIL);
-	report_parse("PARSE_IDENTIFIER_TAIL", this->parse_depth);
+	TRACE_RULE(IDENTFIER_TAIL);
 	if (this->try_match(MP_COMMA)) {
 		this->match(MP_COMMA);
 		this->parse_identifier();
 		this->parse_identifier_tail();
 	} else {
 		// epsilon
-		report_parse("EPSILON_REACHED", this->parse_depth);
+		TRACE_EPSILON();
 		this->create_abstract_node(EPSILON);
 		this->return_from();
 	}
@@ -1095,46 +1210,10 @@ void Parser::parse_identifier_tail() {
 }
 
 void Parser::parse_identifier() {
-	report_parse("GIVE_IDENTIFIER", this->parse_depth);
+	TRACE_RULE(IDENTIFIER);
 	this->match(MP_ID);
 }
 
-bool Parser::is_relational_operator() {
-	report_parse("IS_RELATIONAL_OPERATOR", this->parse_depth);
-	TokType lookahead_type = this->lookahead->get_token();
-	if ((int) lookahead_type <= MP_NOT_EQUAL
-		&& (int) lookahead_type >= MP_EQUALS) {
-		return true;
-	} else {
-		return false;
-	}
-}
-
-bool Parser::is_multiplying_operator() {
-	report_parse("IS_MULTIPLYING_OPERATOR", this->parse_depth);
-	TokType lookahead_type = this->lookahead->get_token();
-	if ((int) lookahead_type <= MP_MOD_KW
-		&& (int) lookahead_type >= MP_MULT) {
-		return true;
-	} else if ((int) lookahead_type == MP_AND) {
-		return true;
-	} else {
-		return false;
-	}
-}
-
-bool Parser::is_adding_operator() {
-	report_parse("IS_ADDING_OPERATOR", this->parse_depth);
-	TokType lookahead_type = this->lookahead->get_token();
-	if ((int) lookahead_type == MP_PLUS
-		|| (int) lookahead_type == MP_MINUS
-		|| (int) lookahead_type == MP_OR) {
-		return true;
-	} else {
-		return false;
-	}
-}
-
 void Parser::more_indent() {
 	this->parse_depth++;
 }
@@ -1148,19 +1227,25 @@ void Parser::return_from() {
 }
 
 void Parser::create_abstract_node(ParseType parse_type) {
-	this->analyzer->get_ast()->add_move_child(AbstractNodePtr(new AbstractNode(parse_type)));
+	this->analyzer->get_ast()->add_move_child(parse_type);
 }
 
-void Parser::create_abstract_node_literal(TokenPtr token) {
-	this->analyzer->get_ast()->add_move_child(AbstractNodePtr(new AbstractNode(token)));
+void Parser::create_abstract_node_literal(const Token& token) {
+	this->analyzer->get_ast()->add_move_child(token, this->lookahead->get_input());
 }
 
 SemanticAnalyzerPtr Parser::get_analyzer() {
 	return this->analyzer;
 }
 
+#if PARSE_TRACE
+ParseTrace& Parser::get_trace() {
+	return this->trace;
+}
+#endif
+
 TokenPtr Parser::get_token() {
-	return this->lookahead;
+	return this->lookahead->get_token(0);
 }
 
 void Parser::begin_symbol(bool var_skip) {
@@ -1316,8 +1401,9 @@ void Parser::end_symbol(SymType symbol_type, ActivationType call_type) {
 				return;
 			}
 		} else {
-			// end is just another argument
-			symbol_end = this->symbols->end();
+			// end is just another argument, the loop
+			// below runs up to and including symbol_end
+			symbol_end = this->symbols->end() - 1;
 			if (this->symbols->size() == 1) {
 				// create function or procedure call
 				table->create_callable(callable_name, return_type, argument_list, row, col);
@@ -8,6 +8,8 @@
 #include "Symbols.hpp"
 #include "Scanner.hpp"
 #include "SemanticAnalyzer.hpp"
+#include "Grammar.hpp"
+#include "ParseTrace.hpp"
 
 class Parser;
 using ParserPtr = shared_ptr<Parser>;
@@ -16,7 +18,18 @@ using ParserPtr = shared_ptr<Parser>;
 class Parser {
 private:
 	ScannerPtr scanner;
-	TokenPtr lookahead;
+	// tokens scanned ahead of the parser, the first is the lookahead
+	enum { lookahead_capacity = 256 };
+	TokenRingPtr lookahead;
+	
+	// the scanner's thread, when scanning runs ahead on its own
+	ScanPipelinePtr pipeline;
+	
+	// the grammar, when parsing from its predict table on
+	// an explicit stack instead of by recursive descent
+	GrammarPtr grammar;
+	vector<GrammarSymbol> parse_stack;
+	vector<ConditionalBlockPtr> conditionals;
     TokenListPtr symbols;
     SemanticAnalyzerPtr analyzer;
     bool error_reported;
@@ -24,13 +37,31 @@ private:
     bool var_skip;
     shared_ptr<stack<int>> gen_collect;
     unsigned int parse_depth;
+	// how tightly infix operators bind, for precedence climbing
+	enum BindingPower { NO_POWER, RELATIONAL_POWER, ADDING_POWER, MULTIPLYING_POWER };
+	unsigned int expression_depth;
+	#if PARSE_TRACE
+	// events of the parse, only when tracing is built in
+	ParseTrace trace;
+	#endif
 public:
 	Parser(ScannerPtr scanner, SemanticAnalyzerPtr analyzer);
 	virtual ~Parser() = default;
 	void parse();
+	void set_pipelined(bool pipelined);
+	void set_table_driven(bool table_driven);
     void populate();
+    TokType lookahead_kind();
 	void match(TokType expected);
+	TokenPtr match_token(TokType expected);
 	bool try_match(TokType expected);
+	// table driven parse and its semantic action hooks
+	void parse_table_driven();
+	void run_action(GrammarAction action);
+	void report_result();
+	#if PARSE_TRACE
+	ParseTrace& get_trace();
+	#endif
 	// parse for all Mikropascal non-terminals
 	void parse_system_goal();
 	void parse_program();
@@ -85,16 +116,10 @@ public:
 	void parse_actual_parameter();
 	// parse expressions
 	void parse_expression();
-	void parse_optional_relational_part();
-	void parse_relational_operator();
-	void parse_simple_expression();
-	void parse_term_tail();
-	void parse_optional_sign();
-	void parse_adding_operator();
-	void parse_term();
-	void parse_factor_tail();
-	void parse_multiplying_operator();
-	void parse_factor();
+	void parse_expression_tree();
+	AbstractIndex parse_precedence(Expression& expression, unsigned int min_power);
+	AbstractIndex parse_operand(Expression& expression);
+	static unsigned int get_binding_power(TokType token);
 	// parse identifiers
 	void parse_program_identifier();
 	void parse_variable_identifier();
@@ -107,10 +132,6 @@ public:
 	void parse_identifier();
 	// parse end of file
 	void parse_eof();
-	// helper functions
-	bool is_relational_operator();
-	bool is_multiplying_operator();
-    bool is_adding_operator();
     // grab the next token from the input stream
 	void next_token();
     TokenPtr get_token();
@@ -120,7 +141,7 @@ public:
     // ast helper methods
     void return_from();
     void create_abstract_node(ParseType parse_type);
-    void create_abstract_node_literal(TokenPtr token);
+    void create_abstract_node_literal(const Token& token);
     SemanticAnalyzerPtr get_analyzer();
     void begin_symbol(bool var_skip);
     void end_symbol(SymType symbol_type, ActivationType callable_type);
@@ -56,16 +56,6 @@ enum ParseType {
 	ACTUAL_PARAMETER,
 	// parse expressions
 	EXPRESSION,
-	OPTIONAL_RELATIONAL_PART,
-	RELATIONAL_OPERATOR,
-	SIMPLE_EXPRESSION,
-	TERM_TAIL,
-	OPTIONAL_SIGN,
-	ADDING_OPERATOR,
-	TERM,
-	FACTOR_TAIL,
-	MULTIPLYING_OPERATOR,
-	FACTOR,
 	// parse identifiers
 	PROGRAM_IDENTIFIER,
 	VARIABLE_IDENTIFIER,
@@ -189,26 +179,6 @@ static string get_rule_info(ParseType rule) {
 		// parse expressions
 	case EXPRESSION:
 		return "EXPRESSION";
-	case OPTIONAL_RELATIONAL_PART:
-		return "OPTIONAL_RELATIONAL_PART";
-	case RELATIONAL_OPERATOR:
-		return "RELATIONAL_OPERATOR";
-	case SIMPLE_EXPRESSION:
-		return "SIMPLE_EXPRESSION";
-	case TERM_TAIL:
-		return "TERM_TAIL";
-	case OPTIONAL_SIGN:
-		return "OPTIONAL_SIGN";
-	case ADDING_OPERATOR:
-		return "ADDING_OPERATOR";
-	case TERM:
-		return "TERM";
-	case FACTOR_TAIL:
-		return "FACTOR_TAIL";
-	case MULTIPLYING_OPERATOR:
-		return "MULTIPLYING_OPERATOR";
-	case FACTOR:
-		return "FACTOR";
 		// parse identifiers
 	case PROGRAM_IDENTIFIER:
 		return "PROGRAM_IDENTIFIER";
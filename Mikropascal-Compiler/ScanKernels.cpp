@@ -0,0 +1,273 @@
+#include "ScanKernels.hpp"
+
+// instruction sets, sse2 is always there on x64 builds and
+// avx2 is compiled in for x86 but only used if the cpu has it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MP_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(MP_SSE2) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+#define MP_AVX2
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// gcc and clang need avx2 code marked, msvc does not
+#if defined(MP_AVX2) && defined(__GNUC__)
+#define MP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define MP_TARGET_AVX2
+#endif
+
+// byte classes shared by every kernel
+
+static inline bool is_space_byte(char c) {
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline bool is_printable_byte(char c) {
+	return c >= ' ' && c <= '~';
+}
+
+static inline bool is_comment_byte(char c) {
+	return (is_printable_byte(c) && c != '{' && c != '}') || (c >= '\t' && c <= '\r');
+}
+
+static inline bool is_string_byte(char c) {
+	return is_printable_byte(c) && c != '\'';
+}
+
+// scalar kernels, also used for the tail of the vector kernels
+
+static const char* skip_whitespace_scalar(const char* first, const char* last) {
+	while (first != last && is_space_byte(*first)) {
+		first++;
+	}
+	return first;
+}
+
+static const char* skip_comment_body_scalar(const char* first, const char* last) {
+	while (first != last && is_comment_byte(*first)) {
+		first++;
+	}
+	return first;
+}
+
+static const char* skip_string_body_scalar(const char* first, const char* last) {
+	while (first != last && is_string_byte(*first)) {
+		first++;
+	}
+	return first;
+}
+
+#ifdef MP_SSE2
+
+static inline unsigned int first_set(uint32_t mask) {
+	// index of the lowest set bit, mask is never zero
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (unsigned int) index;
+#else
+	return (unsigned int) __builtin_ctz(mask);
+#endif
+}
+
+// sse2 kernels, 16 bytes at a time, every comparison is signed
+// so bytes above 0x7f compare as negative and fall out of range
+
+static const char* skip_whitespace_sse2(const char* first, const char* last) {
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i below_tab = _mm_set1_epi8('\t' - 1);
+	const __m128i above_return = _mm_set1_epi8('\r' + 1);
+	while (last - first >= 16) {
+		__m128i block = _mm_loadu_si128((const __m128i*) first);
+		__m128i controls = _mm_and_si128(_mm_cmpgt_epi8(block, below_tab),
+										 _mm_cmplt_epi8(block, above_return));
+		__m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(block, space), controls);
+		uint32_t stop = ~(uint32_t) _mm_movemask_epi8(spaces) & 0xFFFF;
+		if (stop != 0) {
+			return first + first_set(stop);
+		}
+		first += 16;
+	}
+	return skip_whitespace_scalar(first, last);
+}
+
+static const char* skip_comment_body_sse2(const char* first, const char* last) {
+	const __m128i below_space = _mm_set1_epi8(' ' - 1);
+	const __m128i above_tilde = _mm_set1_epi8('~' + 1);
+	const __m128i below_tab = _mm_set1_epi8('\t' - 1);
+	const __m128i above_return = _mm_set1_epi8('\r' + 1);
+	const __m128i left_brace = _mm_set1_epi8('{');
+	const __m128i right_brace = _mm_set1_epi8('}');
+	while (last - first >= 16) {
+		__m128i block = _mm_loadu_si128((const __m128i*) first);
+		__m128i printable = _mm_and_si128(_mm_cmpgt_epi8(block, below_space),
+										  _mm_cmplt_epi8(block, above_tilde));
+		__m128i braces = _mm_or_si128(_mm_cmpeq_epi8(block, left_brace),
+									  _mm_cmpeq_epi8(block, right_brace));
+		__m128i controls = _mm_and_si128(_mm_cmpgt_epi8(block, below_tab),
+										 _mm_cmplt_epi8(block, above_return));
+		__m128i body = _mm_or_si128(_mm_andnot_si128(braces, printable), controls);
+		uint32_t stop = ~(uint32_t) _mm_movemask_epi8(body) & 0xFFFF;
+		if (stop != 0) {
+			return first + first_set(stop);
+		}
+		first += 16;
+	}
+	return skip_comment_body_scalar(first, last);
+}
+
+static const char* skip_string_body_sse2(const char* first, const char* last) {
+	const __m128i below_space = _mm_set1_epi8(' ' - 1);
+	const __m128i above_tilde = _mm_set1_epi8('~' + 1);
+	const __m128i quote = _mm_set1_epi8('\'');
+	while (last - first >= 16) {
+		__m128i block = _mm_loadu_si128((const __m128i*) first);
+		__m128i printable = _mm_and_si128(_mm_cmpgt_epi8(block, below_space),
+										  _mm_cmplt_epi8(block, above_tilde));
+		__m128i body = _mm_andnot_si128(_mm_cmpeq_epi8(block, quote), printable);
+		uint32_t stop = ~(uint32_t) _mm_movemask_epi8(body) & 0xFFFF;
+		if (stop != 0) {
+			return first + first_set(stop);
+		}
+		first += 16;
+	}
+	return skip_string_body_scalar(first, last);
+}
+
+#endif
+
+#ifdef MP_AVX2
+
+// avx2 kernels, the same tests 32 bytes at a time, avx2 has no
+// less than so a < b is written as b > a
+
+MP_TARGET_AVX2
+static const char* skip_whitespace_avx2(const char* first, const char* last) {
+	const __m256i space = _mm256_set1_epi8(' ');
+	const __m256i below_tab = _mm256_set1_epi8('\t' - 1);
+	const __m256i above_return = _mm256_set1_epi8('\r' + 1);
+	while (last - first >= 32) {
+		__m256i block = _mm256_loadu_si256((const __m256i*) first);
+		__m256i controls = _mm256_and_si256(_mm256_cmpgt_epi8(block, below_tab),
+											_mm256_cmpgt_epi8(above_return, block));
+		__m256i spaces = _mm256_or_si256(_mm256_cmpeq_epi8(block, space), controls);
+		uint32_t stop = ~(uint32_t) _mm256_movemask_epi8(spaces);
+		if (stop != 0) {
+			return first + first_set(stop);
+		}
+		first += 32;
+	}
+	return skip_whitespace_sse2(first, last);
+}
+
+MP_TARGET_AVX2
+static const char* skip_comment_body_avx2(const char* first, const char* last) {
+	const __m256i below_space = _mm256_set1_epi8(' ' - 1);
+	const __m256i above_tilde = _mm256_set1_epi8('~' + 1);
+	const __m256i below_tab = _mm256_set1_epi8('\t' - 1);
+	const __m256i above_return = _mm256_set1_epi8('\r' + 1);
+	const __m256i left_brace = _mm256_set1_epi8('{');
+	const __m256i right_brace = _mm256_set1_epi8('}');
+	while (last - first >= 32) {
+		__m256i block = _mm256_loadu_si256((const __m256i*) first);
+		__m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(block, below_space),
+											 _mm256_cmpgt_epi8(above_tilde, block));
+		__m256i braces = _mm256_or_si256(_mm256_cmpeq_epi8(block, left_brace),
+										 _mm256_cmpeq_epi8(block, right_brace));
+		__m256i controls = _mm256_and_si256(_mm256_cmpgt_epi8(block, below_tab),
+											_mm256_cmpgt_epi8(above_return, block));
+		__m256i body = _mm256_or_si256(_mm256_andnot_si256(braces, printable), controls);
+		uint32_t stop = ~(uint32_t) _mm256_movemask_epi8(body);
+		if (stop != 0) {
+			return first + first_set(stop);
+		}
+		first += 32;
+	}
+	return skip_comment_body_sse2(first, last);
+}
+
+MP_TARGET_AVX2
+static const char* skip_string_body_avx2(const char* first, const char* last) {
+	const __m256i below_space = _mm256_set1_epi8(' ' - 1);
+	const __m256i above_tilde = _mm256_set1_epi8('~' + 1);
+	const __m256i quote = _mm256_set1_epi8('\'');
+	while (last - first >= 32) {
+		__m256i block = _mm256_loadu_si256((const __m256i*) first);
+		__m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(block, below_space),
+											 _mm256_cmpgt_epi8(above_tilde, block));
+		__m256i body = _mm256_andnot_si256(_mm256_cmpeq_epi8(block, quote), printable);
+		uint32_t stop = ~(uint32_t) _mm256_movemask_epi8(body);
+		if (stop != 0) {
+			return first + first_set(stop);
+		}
+		first += 32;
+	}
+	return skip_string_body_sse2(first, last);
+}
+
+static bool cpu_has_avx2() {
+	// the cpu must support avx2 and the os must save ymm registers
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	bool has_osxsave = (info[2] & (1 << 27)) != 0;
+	bool has_avx = (info[2] & (1 << 28)) != 0;
+	if (!has_osxsave || !has_avx || (_xgetbv(0) & 6) != 6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+#endif
+
+ScanKernels::ScanKernels() {
+	// start from the portable kernels
+	this->whitespace = skip_whitespace_scalar;
+	this->comment_body = skip_comment_body_scalar;
+	this->string_body = skip_string_body_scalar;
+	this->level = "scalar";
+
+	// MP_SCAN_KERNELS=scalar or sse2 caps the level, for testing
+	const char* cap = getenv("MP_SCAN_KERNELS");
+	string requested = cap == nullptr ? "" : string(cap);
+	if (requested.compare("scalar") == 0) {
+		return;
+	}
+#ifdef MP_SSE2
+	this->whitespace = skip_whitespace_sse2;
+	this->comment_body = skip_comment_body_sse2;
+	this->string_body = skip_string_body_sse2;
+	this->level = "sse2";
+	if (requested.compare("sse2") == 0) {
+		return;
+	}
+#endif
+#ifdef MP_AVX2
+	if (cpu_has_avx2()) {
+		this->whitespace = skip_whitespace_avx2;
+		this->comment_body = skip_comment_body_avx2;
+		this->string_body = skip_string_body_avx2;
+		this->level = "avx2";
+	}
+#endif
+}
+
+ScanKernels& ScanKernels::get() {
+	// picked the first time the scanner needs them
+	static ScanKernels kernels;
+	return kernels;
+}
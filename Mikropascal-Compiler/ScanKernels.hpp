@@ -0,0 +1,41 @@
+#ifndef scan_kernels_h
+#define scan_kernels_h
+
+#include "Standard.hpp"
+
+// a kernel skips a run of bytes the scanner would otherwise step
+// through one at a time, returning the first byte not in the run
+// (or last, if the run reaches the end of the input)
+using ScanKernel = const char* (*)(const char* first, const char* last);
+
+// vectorized kernels for the scanner's longest runs, picked
+// once for the running cpu (avx2, sse2 or plain scalar)
+class ScanKernels {
+private:
+	ScanKernel whitespace;
+	ScanKernel comment_body;
+	ScanKernel string_body;
+	string level;
+	ScanKernels();
+public:
+	// kernels for this cpu
+	static ScanKernels& get();
+	// spaces, tabs, newlines, carriage returns, vertical tabs and form feeds
+	const char* skip_whitespace(const char* first, const char* last) {
+		return this->whitespace(first, last);
+	}
+	// printable characters and whitespace, stopping at braces
+	const char* skip_comment_body(const char* first, const char* last) {
+		return this->comment_body(first, last);
+	}
+	// printable characters, stopping at quotes
+	const char* skip_string_body(const char* first, const char* last) {
+		return this->string_body(first, last);
+	}
+	// name of the instruction set in use
+	string get_level() {
+		return this->level;
+	}
+};
+
+#endif
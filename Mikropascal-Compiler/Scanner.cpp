@@ -1,377 +1,687 @@
 #include "Scanner.hpp"
+#include "ScannerTables.hpp"
 
 Scanner::Scanner(shared_ptr<Input> input_ptr) {
 	// scanner constructor initializes all FAs and column, line numbers and file pointer
 	// initialize input
 	this->input_ptr = input_ptr;
-	this->file_buf_ptr = input_ptr->detach_input();
+	this->file_buf = input_ptr->get_view();
 	
-	// initialize token list
-	this->consumed = TokenListPtr(new vector<TokenPtr>);
+	// initialize token stream over the input's buffer
+	this->tokens = TokenStreamPtr(new TokenStream(input_ptr));
+	this->names = &NameTable::global();
+	this->defer_errors = false;
+	this->scan_threads = 1;
 	
-	// initialize all FSAs for MP keywords
-	this->fsmachines = unique_ptr<
-	vector<FSMachinePtr>>(new vector<FSMachinePtr>);
-	
-	// create a scan buffer
-	this->scan_buf = ScanBufPtr(new ScanBuf);
-	
-	// load all machines
-	this->load_keyword_machines();
-	this->load_id_machine();
-	this->load_num_machines();
-	this->load_strand_machines(4);
-	
-	// set the line and column numbers to default
-	this->col_number = 1L;
-	this->line_number = 1L;
+	// the token patterns were built into tables at build time
+	this->scan_machine = &scanner_tables;
+	this->accept_kinds = scanner_accept_kinds;
+	this->find_token_starts();
+	this->kernels = &ScanKernels::get();
 	
 	// put the file pointer on the first character in the buffer
 	this->file_ptr = this->get_begin_fp();
 }
 
-void Scanner::debug_set_input_string(StringPtr input) {
+Scanner::Scanner(Scanner& parent, const char* first, const char* last) {
+	// a worker for one chunk of the parent's input, it shares the
+	// parent's compiled machine and keeps token offsets relative to
+	// the start of the whole input
+	this->input_ptr = parent.input_ptr;
+	this->file_buf = SourceView(parent.get_begin_fp(), last - parent.get_begin_fp());
+	this->tokens = TokenStreamPtr(new TokenStream(parent.input_ptr));
+	this->tokens->set_keep_comments(parent.tokens->get_keep_comments());
+	this->names = &this->chunk_names;
+	this->defer_errors = true;
+	this->scan_threads = 1;
+	this->scan_machine = parent.scan_machine;
+	this->accept_kinds = parent.accept_kinds;
+	this->table_file = parent.table_file;
+	this->token_starts = parent.token_starts;
+	this->kernels = parent.kernels;
+	this->file_ptr = first;
+}
+
+void Scanner::debug_set_input_string(string input) {
 	// for testing purposes only
 	// breaks encapsulation
-	this->file_buf_ptr = input;
-	this->file_ptr = input->begin();
+	this->input_ptr = Input::open_string(input);
+	this->file_buf = this->input_ptr->get_view();
+	this->file_ptr = this->file_buf.begin();
+	this->tokens->set_input(this->input_ptr);
 }
 
-string::iterator Scanner::get_begin_fp() {
+const char* Scanner::get_begin_fp() {
 	// get a pointer to the start of the file
-	return this->file_buf_ptr->begin();
+	return this->file_buf.begin();
 }
 
-string::iterator Scanner::get_end_fp() {
+const char* Scanner::get_end_fp() {
 	// get a pointer to the end of the file
-	return this->file_buf_ptr->end();
+	return this->file_buf.end();
 }
 
 void Scanner::set_fp_begin() {
 	// push the file pointer back to the input's beginning
-	this->file_ptr = this->file_buf_ptr->begin();
+	this->file_ptr = this->file_buf.begin();
 }
 
 void Scanner::reset() {
-	// reset all FSAs, delete all tokens, move file pointer to beginning
-	this->reset_all_auto();
-	this->consumed->clear();
+	// delete all tokens, move file pointer to beginning
+	this->tokens->clear();
 	this->set_fp_begin();
 }
 
-void Scanner::reset_all_auto() {
-	// reset all FSMachines to their default states
-	for (auto i = this->fsmachines->begin();
-		 i != fsmachines->end(); i++) {
-		(*i)->reset();
-	}
+CompiledMachinePtr Scanner::build_machine() {
+	// declare every token by its pattern
+	RegexBuilder patterns;
+	Scanner::load_keyword_patterns(patterns);
+	Scanner::load_id_pattern(patterns);
+	Scanner::load_num_patterns(patterns);
+	Scanner::load_strand_patterns(patterns);
+	
+	// build one minimized DFA out of them, whose final states
+	// carry the name of the winning token by priority
+	return patterns.build();
 }
 
-void Scanner::run_all_auto(string input) {
-	// reset all FSMachines to their default states
-	for (auto i = this->fsmachines->begin();
-		 i != fsmachines->end(); i++) {
-		(*i)->run(input);
+vector<TokType> Scanner::get_accept_kinds(CompiledMachinePtr machine) {
+	// map every final state to its token type once, so
+	// no token needs a search by name
+	vector<TokType> accept_kinds(machine->get_state_count(), MP_ERROR);
+	for (unsigned int i = 0; i < machine->get_state_count(); i++) {
+		if (machine->is_final((uint16_t) i)) {
+			accept_kinds[i] = get_token_by_name(machine->get_accept_name((uint16_t) i));
+		}
 	}
+	return accept_kinds;
 }
 
-void Scanner::scan_all() {
-	// scan over all token until the file pointer reaches the end of file
-	while (!(this->dispatcher()->get_token() == TokType::MP_EOF)){};
+KeywordTable Scanner::build_keywords() {
+	// the reserved words spelled with letters
+	KeywordTable keywords;
+	keywords.min_length = UINT_MAX;
+	keywords.max_length = 0;
+	vector<pair<string, TokType>> words;
+	for (auto i = (int) TokType::MP_SEMI_COLON;
+		 i <= (int) TokType::MP_BOOLEAN; i++) {
+		string keyword = get_token_info((TokType) i).second;
+		if (::isalpha(keyword[0])) {
+			words.push_back(pair<string, TokType>(keyword, (TokType) i));
+			keywords.min_length = min(keywords.min_length, (unsigned int) keyword.size());
+			keywords.max_length = max(keywords.max_length, (unsigned int) keyword.size());
+		}
+	}
+	
+	// try the smallest factors first, until every
+	// word lands in a slot of its own
+	unsigned int* factors = keywords.factors;
+	for (factors[0] = 1; factors[0] < KeywordHash::slot_count; factors[0]++) {
+		for (factors[1] = 1; factors[1] < KeywordHash::slot_count; factors[1]++) {
+			for (factors[2] = 1; factors[2] < KeywordHash::slot_count; factors[2]++) {
+				for (factors[3] = 1; factors[3] < KeywordHash::slot_count; factors[3]++) {
+					keywords.slots.assign(KeywordHash::slot_count, pair<string, TokType>("", MP_ID));
+					bool placed = true;
+					for (auto i = words.begin(); i != words.end() && placed; i++) {
+						unsigned int slot = KeywordHash::hash(factors, i->first.data(), i->first.size());
+						placed = keywords.slots[slot].first.empty();
+						keywords.slots[slot] = *i;
+					}
+					if (placed) {
+						return keywords;
+					}
+				}
+			}
+		}
+	}
+	throw string("No perfect hash places every reserved word");
+}
+
+void Scanner::write_tables(string filename) {
+	// generate ScannerTables.hpp, which has to be redone
+	// whenever a token or its pattern changes
+	CompiledMachinePtr machine = Scanner::build_machine();
+	vector<TokType> accept_kinds = Scanner::get_accept_kinds(machine);
+	KeywordTable keywords = Scanner::build_keywords();
+	ofstream out(filename, ios::out|ios::binary);
+	if (!out.is_open()) {
+		report_msg_type("Invalid File Path", "Could not write " + filename);
+		return;
+	}
+	out << "#ifndef scanner_tables_h\n"
+		<< "#define scanner_tables_h\n\n"
+		<< "// generated by Scanner::write_tables from the token patterns in\n"
+		<< "// Scanner.cpp, do not edit. run the driver with -g to regenerate\n\n"
+		<< "#include \"FiniteAutomata.hpp\"\n"
+		<< "#include \"Tokens.hpp\"\n\n";
+	machine->write_tables(out, "scanner");
+	out << "\nstatic constexpr TokType scanner_accept_kinds[" << accept_kinds.size() << "] = {";
+	for (unsigned int i = 0; i < accept_kinds.size(); i++) {
+		out << "\n\t(TokType) " << (int) accept_kinds[i]
+			<< ((i + 1 < accept_kinds.size()) ? ", " : " ")
+			<< "// " << get_token_info(accept_kinds[i]).first;
+	}
+	out << "\n};\n\nstatic constexpr KeywordSlot scanner_keyword_slots[" << keywords.slots.size() << "] = {";
+	for (unsigned int i = 0; i < keywords.slots.size(); i++) {
+		out << "\n\t{ \"" << keywords.slots[i].first << "\", (TokType) " << (int) keywords.slots[i].second << " }"
+			<< ((i + 1 < keywords.slots.size()) ? "," : "");
+	}
+	out << "\n};\n\nstatic constexpr KeywordHash scanner_keywords = {\n\t"
+		<< keywords.min_length << ", " << keywords.max_length << ",\n\t{ "
+		<< keywords.factors[0] << ", " << keywords.factors[1] << ", "
+		<< keywords.factors[2] << ", " << keywords.factors[3] << " },\n"
+		<< "\tscanner_keyword_slots\n};\n\n#endif\n";
+}
+
+bool Scanner::check_tables() {
+	// the baked tables must match what the patterns build now
+	CompiledMachinePtr machine = Scanner::build_machine();
+	MachineTables built = machine->get_tables();
+	vector<TokType> accept_kinds = Scanner::get_accept_kinds(machine);
+	if (built.num_states != scanner_tables.num_states
+		|| built.num_classes != scanner_tables.num_classes) {
+		return false;
+	}
+	
+	// so must the keyword hash, and it must classify every
+	// reserved word as its own token
+	KeywordTable keywords = Scanner::build_keywords();
+	if (keywords.min_length != scanner_keywords.min_length
+		|| keywords.max_length != scanner_keywords.max_length
+		|| !equal(keywords.factors, keywords.factors + 4, scanner_keywords.factors)) {
+		return false;
+	}
+	for (unsigned int i = 0; i < keywords.slots.size(); i++) {
+		const KeywordSlot& slot = scanner_keywords.slots[i];
+		const string& word = keywords.slots[i].first;
+		if (word.compare(slot.text) != 0 || keywords.slots[i].second != slot.token
+			|| (!word.empty() && scanner_keywords.classify(word.data(), word.size()) != slot.token)) {
+			return false;
+		}
+	}
+	size_t table_size = built.num_states * built.num_classes;
+	return equal(built.byte_classes, built.byte_classes + 256, scanner_tables.byte_classes)
+		&& equal(built.table, built.table + table_size, scanner_tables.table)
+		&& equal(built.accept_bits, built.accept_bits + (built.num_states + 31) / 32,
+				 scanner_tables.accept_bits)
+		&& equal(accept_kinds.begin(), accept_kinds.end(), scanner_accept_kinds);
+}
+
+void Scanner::write_table_file(string filename) {
+	// the same machine as the baked tables, in the binary format
+	ofstream out(filename, ios::out|ios::binary);
+	if (!out.is_open()) {
+		report_msg_type("Invalid File Path", "Could not write " + filename);
+		return;
+	}
+	Scanner::build_machine()->write_binary(out);
 }
 
-void Scanner::skip_whitespace() {
-	// check for space, tab, or newline, or etc...
-	if (this->get_char() == ' ' ||
-		this->get_char() == '\n' ||
-		this->get_char() == '\t' ||
-		this->get_char() == '\r' ||
-		this->get_char() == '\v' ||
-		this->get_char() == '\f') {
-		while(this->get_char() == ' ' ||
-			  this->get_char() == '\n' ||
-			  this->get_char() == '\t' ||
-			  this->get_char() == '\r' ||
-			  this->get_char() == '\v' ||
-			  this->get_char() == '\f')
-			this->forward();
+ScannerTableFilePtr Scanner::load_table_file(string filename) {
+	// map the file and use its tables where they lie
+	ScannerTableFilePtr table_file = ScannerTableFilePtr(new ScannerTableFile());
+	table_file->file = Input::open_file(filename);
+	if (table_file->file == nullptr) {
+		return nullptr;
+	}
+	SourceView view = table_file->file->get_view();
+	vector<string> accept_names;
+	if (!MachineTables::read_binary(view.begin(), view.size(),
+									table_file->machine, accept_names)) {
+		report_msg_type("Invalid Table File", filename + " is not a scanner table file");
+		return nullptr;
+	}
+	
+	// every final state has to accept a token this scanner knows
+	table_file->accept_kinds = vector<TokType>(table_file->machine.num_states, MP_ERROR);
+	for (unsigned int i = 0; i < table_file->machine.num_states; i++) {
+		if (table_file->machine.is_final((uint16_t) i)) {
+			string name = accept_names[table_file->machine.accept_tags[i]];
+			table_file->accept_kinds[i] = get_token_by_name(name);
+			if (table_file->accept_kinds[i] == MP_ERROR
+				&& name.compare(get_token_info(MP_ERROR).first) != 0) {
+				report_msg_type("Invalid Table File", filename + " has unknown token " + name);
+				return nullptr;
+			}
+		}
 	}
+	return table_file;
 }
 
-void Scanner::consume(TokenPtr token) {
-	// add a token to the buffer
-	this->consumed->push_back(token);
+void Scanner::set_table_file(ScannerTableFilePtr table_file) {
+	// scan with a loaded file's tables from here on
+	this->table_file = table_file;
+	this->scan_machine = &table_file->machine;
+	this->accept_kinds = table_file->accept_kinds.data();
+	this->find_token_starts();
 }
 
-TokenPtr Scanner::last_token() {
-	// get the last token added to the buffer
-	return *(this->consumed->end() - 1);
+void Scanner::scan_all() {
+	// scan over all token until the file pointer reaches the end of file,
+	// split up across threads only when asked for (see set_scan_threads)
+	if (this->scan_threads != 1) {
+		this->scan_parallel(this->scan_threads);
+	} else {
+		this->scan_remaining();
+	}
 }
 
-string Scanner::contents() {
-	// dump the buffer contents
-	return string(this->scan_buf->begin(), this->scan_buf->end());
+void Scanner::scan_remaining() {
+	// scan token by token up to the end of file
+	while (this->tokens->get_kind(this->scan_next()) != MP_EOF) {};
+}
+
+vector<const char*> Scanner::find_chunk_cuts(size_t chunk_count) {
+	// split the rest of the input at newlines that are between tokens,
+	// only comments and strings can hide a newline (or a brace or quote)
+	// so the pre-pass just hops from one of them to the next
+	vector<const char*> cuts;
+	const char* last = this->get_end_fp();
+	size_t chunk_size = (last - this->file_ptr) / chunk_count;
+	const char* want = this->file_ptr + chunk_size;
+	const char* next = this->file_ptr;
+	const char* brace = this->file_ptr;
+	const char* quote = this->file_ptr;
+	while (next < last && cuts.size() + 1 < chunk_count) {
+		// the next place a comment or string starts
+		if (brace != last && brace < next) {
+			brace = (const char*) memchr(next, '{', last - next);
+			brace = brace == nullptr ? last : brace;
+		}
+		if (quote != last && quote < next) {
+			quote = (const char*) memchr(next, '\'', last - next);
+			quote = quote == nullptr ? last : quote;
+		}
+		const char* strand = brace < quote ? brace : quote;
+		// any newline before it is a safe place to cut
+		while (want < strand && cuts.size() + 1 < chunk_count) {
+			const char* from = want > next ? want : next;
+			const char* newline = (const char*) memchr(from, '\n', strand - from);
+			if (newline == nullptr || newline + 1 == last) {
+				want = strand;
+				break;
+			}
+			cuts.push_back(newline + 1);
+			want = newline + 1 + chunk_size;
+		}
+		if (strand == last) {
+			break;
+		}
+		// step over the comment or string the way scan_maximal will,
+		// run ons are skipped to the end of their line
+		bool is_comment = *strand == '{';
+		const char* close = is_comment
+			? this->kernels->skip_comment_body(strand + 1, last)
+			: this->kernels->skip_string_body(strand + 1, last);
+		if (close != last && *close == (is_comment ? '}' : '\'')) {
+			next = close + 1;
+		} else {
+			const char* newline = (const char*) memchr(strand + 1, '\n', last - (strand + 1));
+			next = newline == nullptr ? last : newline;
+		}
+	}
+	return cuts;
 }
 
-bool Scanner::some_accept() {
-	// determine if some machines accept
-	for (auto i = this->fsmachines->begin(); i !=
-		 this->fsmachines->end(); i++) {
-		if ((*i)->accepting()) {
-			return true;
+void Scanner::scan_parallel(unsigned int thread_count) {
+	// scan the rest of the input in chunks on a pool of threads,
+	// then merge the chunks' tokens back in order
+	if (thread_count == 0) {
+		thread_count = thread::hardware_concurrency();
+	}
+	// a few chunks per thread evens out uneven chunks
+	size_t chunk_count = thread_count * 4;
+	static const size_t min_chunk_size = 1 << 16;
+	size_t remaining = this->get_end_fp() - this->file_ptr;
+	// scanning stops at a null byte, leave those to a single scanner
+	if (thread_count < 2 || remaining < chunk_count * min_chunk_size
+		|| memchr(this->file_ptr, '\0', remaining) != nullptr) {
+		this->scan_remaining();
+		return;
+	}
+	vector<const char*> cuts = this->find_chunk_cuts(chunk_count);
+	cuts.insert(cuts.begin(), this->file_ptr);
+	cuts.push_back(this->get_end_fp());
+	
+	// one worker scanner per chunk
+	vector<ScannerPtr> workers;
+	for (size_t i = 0; i + 1 < cuts.size(); i++) {
+		workers.push_back(ScannerPtr(new Scanner(*this, cuts[i], cuts[i + 1])));
+	}
+	atomic<size_t> next_chunk(0);
+	vector<thread> pool;
+	for (unsigned int i = 0; i < thread_count && i < workers.size(); i++) {
+		pool.push_back(thread([&workers, &next_chunk]() {
+			size_t chunk;
+			while ((chunk = next_chunk++) < workers.size()) {
+				workers[chunk]->scan_remaining();
+			}
+		}));
+	}
+	for (auto i = pool.begin(); i != pool.end(); i++) {
+		i->join();
+	}
+	
+	// merge, every chunk but the last ends in an end of file that
+	// is dropped, names move over to this scanner's name table
+	for (size_t i = 0; i < workers.size(); i++) {
+		ScannerPtr worker = workers[i];
+		vector<uint32_t> name_map(worker->chunk_names.size());
+		for (uint32_t j = 0; j < name_map.size(); j++) {
+			name_map[j] = this->names->intern(worker->chunk_names.get_name(j));
+		}
+		size_t base = this->tokens->size();
+		size_t count = worker->tokens->size();
+		if (i + 1 < workers.size()) {
+			count--;
+		}
+		this->tokens->append_stream(*worker->tokens, count, name_map);
+		// errors are reported in the order they were scanned
+		for (auto j = worker->deferred_errors.begin(); j != worker->deferred_errors.end(); j++) {
+			this->report_scan_error(*this->tokens, base + *j);
 		}
 	}
-	return false;
+	this->file_ptr = this->get_end_fp();
 }
 
-bool Scanner::none_accept() {
-	// determine if no machines accept
-	for (auto i = this->fsmachines->begin(); i !=
-		 this->fsmachines->end(); i++) {
-		if ((*i)->accepting()) {
-			return false;
+void Scanner::skip_whitespace() {
+	// skip space, tab, or newline, or etc... a whole run at a time
+	this->file_ptr = this->kernels->skip_whitespace(this->file_ptr, this->get_end_fp());
+}
+
+TokenPtr Scanner::scan_one() {
+	// scan the next token and build a record of it
+	return this->tokens->get_token(this->scan_next());
+}
+
+size_t Scanner::scan_next() {
+	// scan until a token lands in the stream, return its index
+	size_t index = TokenStream::filtered;
+	while (index == TokenStream::filtered) {
+		// scan for whitespace
+		this->skip_whitespace();
+		
+		// return EOF on failed scan of end of file, only
+		// the first one is kept in the stream
+		if (this->get_char() == '\0') {
+			if (!this->tokens->empty()
+				&& this->tokens->get_kind(this->tokens->size() - 1) == MP_EOF) {
+				return this->tokens->size() - 1;
+			}
+			return this->tokens->append(MP_EOF, this->get_end_fp() - this->get_begin_fp(), 0,
+										this->names->intern("EOF"));
 		}
+		
+		// scan the longest token from here
+		index = this->scan_maximal();
 	}
-	return true;
+	return index;
 }
 
-FSMachineListPtr Scanner::not_dead() {
-	// return machines not in dead states
-	FSMachineListPtr alive_machines =
-	FSMachineListPtr(new FSMachineList());
-	for (auto i = this->fsmachines->begin(); i !=
-		 this->fsmachines->end(); i++) {
-		if ((*i)->not_dead() == true) {
-			alive_machines->push_back(*i);
+size_t Scanner::refill(TokenRing& ring) {
+	// scan a batch of tokens into the ring until it is full or the
+	// input ends, comments and run on tokens were already reported
+	// so they are dropped here. returns how many tokens went in
+	size_t pushed = 0;
+	this->defer_errors = true;
+	while (!ring.full()) {
+		size_t index = this->scan_next();
+		
+		// hold errors until the parser gets to them
+		for (auto i = this->deferred_errors.begin(); i != this->deferred_errors.end(); i++) {
+			ring.hold_error(this->tokens->get_kind(*i), this->tokens->get_offset(*i),
+							this->tokens->get_length(*i));
+		}
+		this->deferred_errors.clear();
+		TokType kind = this->tokens->get_kind(index);
+		if (kind == MP_COMMENT
+			|| kind == MP_RUN_COMMENT
+			|| kind == MP_RUN_STRING) {
+			continue;
+		}
+		ring.push(kind, this->tokens->get_offset(index), this->tokens->get_length(index),
+				  this->tokens->get_name_id(index));
+		pushed++;
+		if (kind == MP_EOF) {
+			break;
 		}
 	}
-	return alive_machines;
+	
+	// the ring holds everything the parser still needs, so the
+	// stream is emptied to keep memory flat for any input length
+	this->tokens->clear();
+	this->defer_errors = false;
+	return pushed;
 }
 
-FSMachineListPtr Scanner::run_buffer() {
-	// run every machine against the buffer contents
-	this->run_all_auto(this->contents());
-	// return machines not in dead states
-	FSMachineListPtr alive_machines = this->not_dead();
-	return alive_machines;
+void Scanner::report_held_errors(TokenRing& ring) {
+	// report the errors held in the ring that its front has
+	// reached, in the order they were scanned
+	size_t index;
+	while ((index = ring.next_held_error()) != TokenStream::filtered) {
+		this->report_scan_error(ring.get_held_errors(), index);
+	}
 }
 
-FSMachineListPtr Scanner::accepting() {
-	// return a list of all accepting machines
-	// ordered by priority
-	FSMachineListPtr accepting_machines =
-	FSMachineListPtr(new FSMachineList());
-	for (auto i = this->fsmachines->begin(); i !=
-		 this->fsmachines->end(); i++) {
-		if ((*i)->accepting() == true) {
-			accepting_machines->push_back(*i);
+TokenSplice Scanner::rescan(size_t offset, size_t length, const string& replacement) {
+	// replace length bytes at offset in a scanned input, then scan
+	// again only where the edit can change the tokens. scanning keeps
+	// no state between tokens, so once a new token starts past the
+	// edit where an old one did, the rest of the old stream still holds
+	if (!this->input_ptr->check_edit(offset, length, replacement.size())) {
+		return TokenSplice { 0, 0, 0 };
+	}
+	size_t edit_end = offset + length;
+	int64_t shift = (int64_t) replacement.size() - (int64_t) length;
+	size_t old_end = this->file_ptr - this->get_begin_fp();
+	
+	// back up to the last token starting before the edit, and then
+	// over any token whose scan looked as far as the edit
+	size_t first = 0;
+	size_t past = this->tokens->size();
+	while (first < past) {
+		size_t middle = first + (past - first) / 2;
+		if (this->tokens->get_offset(middle) < offset) {
+			first = middle + 1;
+		} else {
+			past = middle;
 		}
 	}
-	sort(accepting_machines->begin(),
-				accepting_machines->end());
-	return accepting_machines;
-}
-
-TokenPtr Scanner::scan_one() {
-	// scan for whitespace
-	this->skip_whitespace();
-	
-	// return EOF on failed scan of
-	// end of file
-	if (this->get_char() == '\0') {
-		TokenPtr new_token = TokenPtr(new Token());
-		new_token->set_token(MP_EOF);
-		new_token->set_lexeme("EOF");
-		new_token->set_line(this->line_number);
-		new_token->set_column(this->col_number);
-		return new_token;
+	if (first > 0) {
+		first--;
+	}
+	while (first > 0 && this->tokens->get_offset(first - 1) + this->scan_reach(first - 1) >= offset) {
+		first--;
+	}
+	// a comment or string that ran on looked for its close to the end
+	// of the input, so an edit anywhere after one can close it
+	first = min(first, this->tokens->get_first_run_on());
+	size_t restart = (first == 0) ? 0 : this->tokens->get_offset(first);
+	
+	// edit the input where it is, and scan it from
+	// there into a stream of its own
+	this->input_ptr->replace(offset, length, replacement);
+	this->file_buf = this->input_ptr->get_view();
+	TokenStreamPtr old_tokens = this->tokens;
+	this->tokens = TokenStreamPtr(new TokenStream(this->input_ptr));
+	this->tokens->set_keep_comments(old_tokens->get_keep_comments());
+	this->file_ptr = this->get_begin_fp() + restart;
+	size_t old_next = first;
+	size_t added = 0;
+	bool resynced = false;
+	while (!resynced) {
+		size_t index = this->scan_next();
+		size_t start = this->tokens->get_offset(index);
+		
+		// find the first old token past the edit that
+		// could start here, stop if one does
+		while (old_next < old_tokens->size()
+			   && (old_tokens->get_offset(old_next) < edit_end
+				   || old_tokens->get_offset(old_next) + shift < (int64_t) start)) {
+			old_next++;
+		}
+		resynced = old_next < old_tokens->size()
+			&& old_tokens->get_offset(old_next) + shift == (int64_t) start
+			&& old_tokens->get_kind(old_next) == this->tokens->get_kind(index);
+		if (resynced) {
+			break;
+		}
+		added++;
+		
+		// an old stream that never got this far is scanned to its end
+		if (this->tokens->get_kind(index) == MP_EOF) {
+			old_next = old_tokens->size();
+			break;
+		}
 	}
 	
-	// throw a character into the buffer
-	this->cache();
+	// splice the new tokens in, the scan picks up where it left off
+	old_tokens->replace(first, old_next - first, *this->tokens, added, shift);
+	old_tokens->move_input(this->input_ptr);
+	if (resynced) {
+		this->file_ptr = this->get_begin_fp() + old_end + shift;
+	}
+	this->tokens = old_tokens;
+	return TokenSplice { first, old_next - first, added };
+}
+
+size_t Scanner::scan_reach(size_t index) {
+	// a token depends on every byte its scan looked at, which can
+	// run past its end. comments and strings look for their closing
+	// character, to the end of the input if it is missing
+	const char* start = this->get_begin_fp() + this->tokens->get_offset(index);
+	size_t rest = this->get_end_fp() - start;
+	switch (this->tokens->get_kind(index)) {
+		case MP_EOF:
+			return 0;
+		case MP_RUN_COMMENT:
+		case MP_RUN_STRING:
+			return rest;
+		case MP_COMMENT:
+		case MP_STRING_LITERAL:
+			return this->tokens->get_length(index);
+		case MP_ERROR:
+			return min(rest, (size_t) this->tokens->get_length(index) + 1);
+		default:
+			break;
+	}
+	// everything else ran the machine until it died, the byte
+	// that killed it was looked at too
+	size_t stepped = 0;
+	uint16_t state = CompiledMachine::initial_state;
+	while (stepped < rest) {
+		state = this->scan_machine->next(state, start[stepped]);
+		if (state == CompiledMachine::dead_state) {
+			return stepped + 1;
+		}
+		stepped++;
+	}
+	return stepped;
+}
+
+size_t Scanner::scan_maximal() {
+	// remember where the token starts
+	const char* token_start = this->file_ptr;
+	
+	// comments and strings are the longest tokens, find their
+	// closing character with a kernel instead of stepping the
+	// machine over every byte of the body
+	if (*token_start == '{' || *token_start == '\'') {
+		bool is_comment = *token_start == '{';
+		const char* close = is_comment
+			? this->kernels->skip_comment_body(token_start + 1, this->get_end_fp())
+			: this->kernels->skip_string_body(token_start + 1, this->get_end_fp());
+		if (close != this->get_end_fp() && *close == (is_comment ? '}' : '\'')) {
+			this->file_ptr = close + 1;
+			return this->tokens->append(is_comment ? MP_COMMENT : MP_STRING_LITERAL,
+										token_start - this->get_begin_fp(),
+										close + 1 - token_start, NameTable::no_name);
+		}
+		// unterminated, no other token starts with a brace or a
+		// quote so the machine cannot do better. scanning picks up
+		// again at the end of the line
+		const char* line_end = (const char*) memchr(token_start + 1, '\n',
+													this->get_end_fp() - token_start - 1);
+		this->file_ptr = (line_end != nullptr) ? line_end : this->get_end_fp();
+		return this->append_error(is_comment ? MP_RUN_COMMENT : MP_RUN_STRING, token_start, 1);
+	}
 	
-	// move the input pointer forward
-	this->forward();
+	// the last position some machine accepted at
+	const char* accept_ptr = token_start;
+	uint16_t accept_state = CompiledMachine::dead_state;
 	
-	// run buffer, then check to see what scanning
-	// mode we should be in
-	this->run_buffer();
+	// step the combined machine forward until it dies,
+	// recording every accepting position along the way
+	uint16_t state = CompiledMachine::initial_state;
+	while (this->file_ptr != this->get_end_fp()) {
+		state = this->scan_machine->next(state, *this->file_ptr);
+		if (state == CompiledMachine::dead_state) {
+			break;
+		}
+		this->forward();
+		if (this->scan_machine->is_final(state)) {
+			accept_ptr = this->file_ptr;
+			accept_state = state;
+		}
+	}
 	
-	// if none accept, scan to the end of the input
-	// to try to accept
-	if (this->none_accept()) {
-		// scan until we find something, or reach EOF
-		this->reset_all_auto();
-		return this->scan_infinite();
+	if (accept_state != CompiledMachine::dead_state) {
+		// jump back to the end of the longest match
+		this->file_ptr = accept_ptr;
+		// append a token from the highest priority machine
+		TokType this_tok = this->accept_kinds[accept_state];
+		// identifiers may be reserved words, the rest are
+		// interned, everything else stays a span
+		uint32_t name_id = NameTable::no_name;
+		if (this_tok == MP_ID) {
+			this_tok = scanner_keywords.classify(token_start, accept_ptr - token_start);
+		}
+		if (this_tok == MP_ID) {
+			name_id = this->names->intern_lower(token_start, accept_ptr - token_start);
+		}
+		return this->tokens->append(this_tok, token_start - this->get_begin_fp(),
+									accept_ptr - token_start, name_id);
 	} else {
-		// scan until nothing accepts any longer
-		this->reset_all_auto();
-		return this->scan_finite();
-	}
-}
-
-void Scanner::shave_all() {
-	// shave both the scan buffer
-	// by a character and rewind the file
-	// pointer by one
-	this->shave_buffer();
-	this->shave_file_ptr();
-}
-
-void Scanner::shave_buffer() {
-	// pop the scan buffer
-	this->scan_buf->pop_back();
-}
-
-void Scanner::shave_file_ptr() {
-	// rewind the file pointer by one
-	this->rewind();
-}
-
-void Scanner::shave_chain() {
-	// shave all
-	this->shave_all();
-	// reset all machines
-	this->reset_all_auto();
-	// run buffer
-	this->run_buffer();
-}
-
-void Scanner::clear_buffer() {
-	// clear the scan buffer
-	this->scan_buf->clear();
-}
-
-void Scanner::run_chain() {
-	// standard run chain for all buffer moves
-	// reset all machines to their start states
-	this->reset_all_auto();
-	// cache the current token under the fp
-	this->cache();
-	// move the file pointer forward 1
-	this->forward();
-	// run the entire buffer against the automata
-	// individually
-	this->run_buffer();
-	// use with some, no, and not_dead()
-}
-
-TokenPtr Scanner::scan_infinite() {
-	// a token pointer to see what we can get
-	TokenPtr new_token = TokenPtr(new Token());
-	unsigned long start_line = this->line_number;
-	unsigned long start_column = this->col_number;
-	new_token->set_line(start_line);
-	new_token->set_column(--start_column);
-	// moves to the end of the buffer
-	unsigned int moves = 0;
-	// scan until the null character
-	while (this->get_char() != '\0') {
-		// run the buffer
-		this->run_buffer();
-		// check if a machine accepted
-		if (some_accept()) {
-			// if some machine(s) is(are) accepting
-			while(!none_accept() || this->not_dead()->size() > 0) {
-				// scan until none accept
-				this->run_chain();
-			}
-			// shave chain
-			this->shave_chain();
-			// error condition checked
-			if (this->none_accept()) {
-				break;
-			}
-			// some will accept, since
-			// the condition above satisfies it
-			// get first high priority accepting machines
-			FSMachinePtr accepting = move(*this->accepting()->begin());
-			string token_name = accepting->get_name();
-			// create a token
-			TokType this_tok = get_token_by_name(token_name);
-			new_token->set_token(this_tok);
-			string contents = this->contents();
-			contents = to_lower(contents);
-			new_token->set_lexeme(contents);
-			// clear buffer
-			this->clear_buffer();
-			// return new token
-			this->consume(new_token);
-			return new_token;
-		} else {
-			this->reset_all_auto();
-			// cache the current token under the fp
-			this->cache();
-			// move the file pointer forward 1
-			this->forward();
-			// run the entire buffer against the automata
-			// individually
-		}
-		moves++;
-	}
-	// error condition
-	// unwind the file pointer back to the first item
-	for (unsigned int i = moves; i > 0; i--) {
-		this->shave_all();
-	}
-	if (*this->scan_buf->begin() == '\'') {
-		new_token->set_token(MP_RUN_STRING);
-		new_token->set_error("There is a run on string here");
-		this->goto_next('\n');
-	} else if (*this->scan_buf->begin() == '{') {
-		new_token->set_token(MP_RUN_COMMENT);
-		new_token->set_error("There is a run on comment here");
-		this->goto_next('\n');
+		// error condition, nothing accepted so jump back to just
+		// past the first character, then over every following
+		// character that cannot start a token either, so a run of
+		// bad characters makes one error token
+		this->file_ptr = token_start + 1;
+		while (this->file_ptr != this->get_end_fp()
+			   && !this->token_starts[(unsigned char) *this->file_ptr]) {
+			this->file_ptr++;
+		}
+		return this->append_error(MP_ERROR, token_start, this->file_ptr - token_start);
+	}
+}
+
+size_t Scanner::append_error(TokType error_tok, const char* token_start, size_t length) {
+	// append the error token
+	size_t index = this->tokens->append(error_tok, token_start - this->get_begin_fp(), length,
+										NameTable::no_name);
+	// workers hold on to their errors until they are merged
+	if (this->defer_errors) {
+		this->deferred_errors.push_back(index);
 	} else {
-		new_token->set_token(MP_ERROR);
-		new_token->set_error("There is an unreconized token here");
+		this->report_scan_error(*this->tokens, index);
 	}
-	// create the error token
-	string contents = this->contents();
-	contents = to_lower(contents);
-	new_token->set_lexeme(contents);
+	return index;
+}
+
+void Scanner::find_token_starts() {
+	// characters the machine can take a first step on, and
+	// whitespace, end a run of bad characters
+	for (unsigned int b = 0; b < 256; b++) {
+		this->token_starts[b] = this->scan_machine->next(CompiledMachine::initial_state, (char) b)
+			!= CompiledMachine::dead_state || b == ' ' || (b >= '\t' && b <= '\r');
+	}
+}
+
+void Scanner::report_scan_error(TokenStream& stream, size_t index) {
 	// hidden error message here? (might be good)
-	report_error_lc("Scan Error", new_token->get_error() + contents,
-					start_line, start_column);
-	// clear buffer
-	this->clear_buffer();
-	// return error token
-	this->consume(new_token);
-	return new_token;
-}
-
-TokenPtr Scanner::scan_finite() {
-	// token to build
-	TokenPtr new_token = TokenPtr(new Token());
-	new_token->set_line(this->line_number);
-	unsigned long cur_col = this->col_number;
-	new_token->set_column(--cur_col);
-	// wait until no state machine accepts
-	while (!this->none_accept() || this->not_dead()->size() > 0) {
-		// check for the null pointed item
-		if (this->get_char() == '\0') {
-			break;
-		}
-		// store and forward
-		this->run_chain();
-	}
-	// shave off the end of the buffer
-	this->shave_chain();
-	// get first high priority accepting machine
-	FSMachineListPtr accepting_list = this->accepting();
-	FSMachinePtr accepting = move(*accepting_list->begin());
-	string token_name = accepting->get_name();
-	// create a token
-	TokType this_tok = get_token_by_name(token_name);
-	new_token->set_token(this_tok);
-	string contents = this->contents();
-	contents = to_lower(contents);
-	new_token->set_lexeme(contents);
-	// clear buffer
-	this->clear_buffer();
-	// return new token
-	this->consume(new_token);
-	return new_token;
+	report_error_lc("Scan Error", string(get_token_error(stream.get_kind(index)))
+					+ stream.get_lexeme(index),
+					stream.get_line(index), stream.get_column(index));
 }
 
 TokenPtr create_token(TokType token, string lexeme,
@@ -382,7 +692,7 @@ TokenPtr create_token(TokType token, string lexeme,
 
 int Scanner::get_char() {
 	// look at the current char in the input
-	if (this->file_ptr != this->file_buf_ptr->end())
+	if (this->file_ptr != this->get_end_fp())
 		// if not end, character is valid
 		return *(this->file_ptr);
 	else
@@ -390,23 +700,10 @@ int Scanner::get_char() {
 		return '\0';
 }
 
-void Scanner::cache() {
-	// get char and push onto the buffer
-	char c = get_char();
-	this->scan_buf->push_back(c);
-}
-
 bool Scanner::forward() {
-	// move the file pointer to the right by one
-	if (this->file_ptr != this->file_buf_ptr->end()) {
-		// deal with line and column numbers
-		if (this->get_char() == '\n') {
-			this->line_number++;
-			this->col_number = 1;
-		} else {
-			this->col_number++;
-		}
-		// move forward
+	// move the file pointer to the right by one, line and
+	// column numbers come from the input's line index instead
+	if (this->file_ptr != this->get_end_fp()) {
 		this->file_ptr++;
 		return true;
 	} else {
@@ -414,207 +711,57 @@ bool Scanner::forward() {
 	}
 }
 
-bool Scanner::rewind() {
-	// move the file pointer to the left by one
-	if (this->file_ptr != this->file_buf_ptr->begin()) {
-		// decreased the file ptr
-		this->file_ptr--;
-		if (this->get_char() == '\n') {
-			// deal with the remaining column size
-			this->line_number--;
-			// save the file pointer
-			string::iterator saved = this->file_ptr;
-			unsigned int col_size = 0;
-			char current = '\0';
-			// rewind until we reach the beginning
-			// of file or beginning of line
-			do {
-				this->file_ptr--;
-				col_size++;
-				current = this->get_char();
-			} while (current != '\0' && current != '\n');
-			// if we're at the beginning of the file
-			// then we increment the line number by 1
-			if (current == '\0') {
-				this->line_number++;
-			}
-			// restore the saved file pointer
-			this->file_ptr = saved;
-			// restore the saved line number
-			this->col_number = col_size;
-		} else {
-			this->col_number--;
-		}
-		return true;
-	} else {
-		return false;
-	}
-}
-
 void Scanner::goto_next(char c) {
 	// go to the next character specified
 	while(this->get_char() != c) {
-		// go forward
-		this->forward();
+		// go forward, stopping at the end of input
+		if (!this->forward()) {
+			break;
+		}
 	}
 }
 
-void Scanner::load_keyword_machines() {
+void Scanner::load_keyword_patterns(RegexBuilder& patterns) {
 	// get the token type for all keyworded or single char types
 	for (auto i = (int) TokType::MP_SEMI_COLON;
 		 i <= (int) TokType::MP_BOOLEAN; i++) {
 		
-		// create new automata for all types
-		FSMachinePtr new_fa = FSMachinePtr(
-		new FiniteMachineContainer(get_token_info((TokType)i).first, true));
-		
-		// build the keyword into the automata
-		new_fa->build_keyword(get_token_info((TokType)i).second);
-		
-		// set priority: keywords are always more important than ids
-		new_fa->set_priority(1);
+		// words spelled with letters are scanned as identifiers
+		// and picked out by the keyword hash, so only symbols
+		// need their own patterns
+		string keyword = get_token_info((TokType)i).second;
+		if (::isalpha(keyword[0])) {
+			continue;
+		}
 		
-		// add to the vector of automata
-		this->fsmachines->push_back(FSMachinePtr(new_fa));
+		// keywords are always more important than ids
+		patterns.add_token(get_token_info((TokType)i).first,
+						   RegexBuilder::escape(keyword), 1);
 	}
 }
 
-// load automata for scanning valid identifiers
-void Scanner::load_id_machine() {
-	// create the id scan automata
-	auto id_machine = FSMachinePtr(
-	new FiniteMachineContainer(get_token_info(TokType::MP_ID).first,
-	true));
-	
-	// detects ids without two underscores
-	id_machine->add_state("0", true, false);
-	id_machine->add_state("1", false, true);
-	id_machine->add_state("2", false, true);
-	id_machine->add_state("3", false, false);
-	id_machine->add_state("4", false, false);
-	
-	// add transitions
-	id_machine->add_alphabet("0", "1");
-	id_machine->add_alphabet("1", "1");
-	id_machine->add_digits("1", "1");
-	id_machine->add_transition("1", '_', "4");
-	id_machine->add_alphabet("4", "1");
-	id_machine->add_digits("4", "1");
-	
-	// other part
-	id_machine->add_transition("0", '_', "3");
-	id_machine->add_alphabet("3", "2");
-	id_machine->add_digits("3", "2");
-	id_machine->add_alphabet("2", "2");
-	id_machine->add_digits("2", "2");
-	id_machine->add_transition("2", '_', "3");
-	
-	// set priority
-	id_machine->set_priority(2);
-	
-	// add to finite machines
-	this->fsmachines->push_back(FSMachinePtr(id_machine));
+void Scanner::load_id_pattern(RegexBuilder& patterns) {
+	// letters and digits starting with a letter or underscore,
+	// an underscore is never doubled nor last
+	patterns.add_token(get_token_info(TokType::MP_ID).first,
+					   "[A-Za-z][A-Za-z0-9]*(_[A-Za-z0-9]+)*|(_[A-Za-z0-9]+)+", 2);
 }
 
-void Scanner::load_num_machines() {
-	// create floating point automata for scanning numeric literals
-	auto float_machine = FSMachinePtr(
-	new FiniteMachineContainer(get_token_info(TokType::MP_FLOAT_LITERAL).first, true));
-	
-	// add states to this DFA, first and final
-	float_machine->add_state("0", true, false);
-	float_machine->add_state("1", false, false);
-	float_machine->add_state("2", false, true);
-	float_machine->add_state("3", false, false);
-	float_machine->add_state("4", false, false);
-	float_machine->add_state("5", false, true);
-	float_machine->add_digits("0", "1");
-	float_machine->add_digits("1", "1");
-	float_machine->add_transition("1", '.', "2");
-	float_machine->add_digits("2", "2");
-	float_machine->add_transition("2", 'e', "3");
-	float_machine->add_transition("2", 'E', "3");
-	float_machine->add_transition("3", '+', "4");
-	float_machine->add_transition("3", '-', "4");
-	float_machine->add_digits("3", "5");
-	float_machine->add_digits("4", "5");
-	float_machine->add_digits("5", "5");
-	
-	// create integer automata
-	auto integer_machine = FSMachinePtr(
-	new FiniteMachineContainer(get_token_info(TokType::MP_INT_LITERAL).first, true));
-	
-	// add states to this DFA
-	integer_machine->add_state("0", true, false);
-	integer_machine->add_state("1", false, true);
-	integer_machine->add_digits("0", "1");
-	integer_machine->add_digits("1", "1");
-	
-	// reset both
-	float_machine->reset();
-	integer_machine->reset();
-	
-	// set machine priorities
-	float_machine->set_priority(1);
-	integer_machine->set_priority(1);
-	
-	// add both to the finite machines list
-	this->fsmachines->push_back(FSMachinePtr(float_machine));
-	this->fsmachines->push_back(FSMachinePtr(integer_machine));
+void Scanner::load_num_patterns(RegexBuilder& patterns) {
+	// floats need a dot, the exponent is optional
+	patterns.add_token(get_token_info(TokType::MP_FLOAT_LITERAL).first,
+					   "[0-9]+\\.[0-9]*([eE][+-]?[0-9]+)?", 1);
+	patterns.add_token(get_token_info(TokType::MP_INT_LITERAL).first,
+					   "[0-9]+", 1);
 }
 
-void Scanner::load_strand_machines(unsigned int within) {
-	// comments and strings, take that!
-	// add nested strings and comments feature using within variable
-	auto comment_machine = FSMachinePtr(
-	new FiniteMachineContainer(get_token_info(TokType::MP_COMMENT).first, true));
-	
-	// add states
-	comment_machine->add_state("0", true, false);
-	comment_machine->add_state("1", false, false);
-	comment_machine->add_state("2", false, true);
-	
-	// for state 1
-	comment_machine->add_alphabet("1", "1");
-	comment_machine->add_symbols("1", "1");
-	comment_machine->add_digits("1", "1");
-	comment_machine->add_transition("1", ' ', "1");
-	comment_machine->add_transition("1", '\n', "1");
-	comment_machine->add_transition("1", '\t', "1");
-	comment_machine->add_transition("1", '\v', "1");
-	comment_machine->add_transition("1", '\r', "1");
-	comment_machine->add_transition("1", '\f', "1");
-	comment_machine->remove_transition("1", '{');
-	comment_machine->remove_transition("1", '}');
-	comment_machine->add_transition("0", '{', "1");
-	comment_machine->add_transition("1", '}', "2");
-	
-	// new machine
-	auto string_machine = FSMachinePtr(
-	new FiniteMachineContainer(get_token_info(TokType::MP_STRING_LITERAL).first, true));
-	
-	// add states
-	string_machine->add_state("0", true, false);
-	string_machine->add_state("1", false, false);
-	string_machine->add_state("2", false, true);
-	
-	// add transitions
-	string_machine->add_transition("0", '\'', "1");
-	string_machine->add_alphabet("1", "1");
-	string_machine->add_symbols("1", "1");
-	string_machine->add_digits("1", "1");
-	string_machine->add_transition("1", ' ', "1");
-	string_machine->remove_transition("1", '\'');
-	string_machine->remove_transition("1", '\'');
-	string_machine->add_transition("1", '\'', "2");
-	
-	// set machine priority
-	comment_machine->set_priority(1);
-	string_machine->set_priority(1);
-	
-	// add the machines to our FSMachines list
-	this->fsmachines->push_back(comment_machine);
-	this->fsmachines->push_back(string_machine);
+void Scanner::load_strand_patterns(RegexBuilder& patterns) {
+	// comments hold printable characters and whitespace but no
+	// braces, strings hold printable characters but no quotes
+	patterns.add_token(get_token_info(TokType::MP_COMMENT).first,
+					   "\\{[\\t-\\r -z|~]*\\}", 1);
+	patterns.add_token(get_token_info(TokType::MP_STRING_LITERAL).first,
+					   "'[ -&(-~]*'", 1);
 }
 
 bool Scanner::isalnum(char next) {
@@ -676,51 +823,151 @@ bool Scanner::isalpha(char next) {
 
 unsigned long Scanner::get_line_number() {
 	// get the scanning line number
-	return this->line_number;
+	return this->input_ptr->get_line(this->file_ptr - this->get_begin_fp());
 }
 
 unsigned long Scanner::get_col_number() {
 	// get the scanning column number
-	return this->col_number;
+	return this->input_ptr->get_column(this->file_ptr - this->get_begin_fp());
 }
 
-// remove comments from the list of consumed tokens
+void Scanner::set_scan_threads(unsigned int thread_count) {
+	// threads scan_all scans on, 0 for every core. inputs too
+	// small to split still scan on the calling thread
+	this->scan_threads = thread_count;
+}
+
+void Scanner::set_keep_comments(bool keep_comments) {
+	// comments are dropped from the stream unless kept
+	this->tokens->set_keep_comments(keep_comments);
+}
+
+// remove comments from the stream of consumed tokens
 void Scanner::thin_comments() {
-	if (this->consumed->size() > 0) {
-		for (vector<TokenPtr>::iterator i =
-		this->consumed->begin();
-		i != consumed->end(); i++)
-		{
-			if ((*i)->get_token() == MP_COMMENT) {
-				this->consumed->erase(i);
-			}
-		}
-	}
+	this->tokens->remove_kind(MP_COMMENT);
 }
 
 // write tokens to a file
 void Scanner::write_tokens_tof(string filename) {
-	if (this->consumed->size() > 0) {
+	if (this->tokens->size() > 0) {
 		ofstream file;
 		file.open(filename);
-		for (vector<TokenPtr>::iterator i =
-			 this->consumed->begin();
-			 i != this->consumed->end(); i++) {
-			file << (*(*i)->to_string()) << '\n';
+		for (size_t i = 0; i < this->tokens->size(); i++) {
+			file << (*this->tokens->get_token(i)->to_string()) << '\n';
 		}
 		file.close();
 	}
 }
 
 void Scanner::display_tokens() {
-	for (vector<TokenPtr>::iterator i = this->consumed->begin();
-		 i != consumed->end(); i++) {
-		report_error_lc("Found", "'" + (*i)->get_lexeme()
-						+ "' : " + get_token_info((*i)->get_token()).first, (*i)->get_line(), (*i)->get_column());
+	for (size_t i = 0; i < this->tokens->size(); i++) {
+		// the end of file marker is not displayed
+		if (this->tokens->get_kind(i) == MP_EOF) {
+			continue;
+		}
+		report_error_lc("Found", "'" + this->tokens->get_lexeme(i)
+						+ "' : " + get_token_info(this->tokens->get_kind(i)).first,
+						this->tokens->get_line(i), this->tokens->get_column(i));
+	}
+}
+
+TokenStreamPtr Scanner::get_tokens() {
+	return this->tokens;
+}
+
+InputPtr Scanner::get_input() {
+	return this->input_ptr;
+}
+
+ScanPipeline::ScanPipeline(ScannerPtr scanner, size_t ring_capacity):
+		head(0), tail(0), stopping(false), finished(false), eof_offset(0), scanner(scanner) {
+	// the thread never touches the global names, the parser side
+	// reads them while the scanner runs
+	for (unsigned int i = 0; i < queue_size; i++) {
+		this->queue[i].ring = TokenRingPtr(new TokenRing(scanner->get_input(), ring_capacity));
 	}
+	this->scanner->names = &this->scanner->chunk_names;
+	this->producer = thread([this]() { this->produce(); });
 }
 
-TokenListPtr Scanner::detach_tokens() {
-	return this->consumed;
+ScanPipeline::~ScanPipeline() {
+	this->stopping.store(true);
+	this->wake();
+	this->producer.join();
 }
 
+void ScanPipeline::wake() {
+	// taking the lock first means the other side is either not
+	// yet checking its counter or already asleep on it
+	{
+		lock_guard<mutex> lock(this->wait_lock);
+	}
+	this->moved.notify_one();
+}
+
+void ScanPipeline::produce() {
+	// keep the queue full until the batch with the end of file,
+	// sleeping whenever the parser is a whole queue behind
+	size_t tail = this->tail.load(memory_order_relaxed);
+	size_t named = this->scanner->chunk_names.size();
+	while (!this->stopping.load(memory_order_relaxed)) {
+		if (tail - this->head.load(memory_order_acquire) == queue_size) {
+			unique_lock<mutex> lock(this->wait_lock);
+			this->moved.wait(lock, [this, tail]() {
+				return this->stopping.load(memory_order_relaxed)
+					|| tail - this->head.load(memory_order_acquire) < queue_size;
+			});
+			continue;
+		}
+		Batch& batch = this->queue[tail & (queue_size - 1)];
+		batch.ring->clear();
+		batch.names.clear();
+		this->scanner->refill(*batch.ring);
+		for (; named < this->scanner->chunk_names.size(); named++) {
+			batch.names.push_back(this->scanner->chunk_names.get_name((uint32_t) named));
+		}
+		
+		// the end of file is always the last token of its batch,
+		// finished is only set once that batch is in the queue
+		TokenRing& ring = *batch.ring;
+		bool ended = !ring.empty() && ring.get_kind(ring.size() - 1) == MP_EOF;
+		if (ended) {
+			this->eof_offset = ring.get_offset(ring.size() - 1);
+		}
+		this->tail.store(++tail, memory_order_release);
+		if (ended) {
+			this->finished.store(true, memory_order_release);
+		}
+		this->wake();
+		if (ended) {
+			return;
+		}
+	}
+}
+
+void ScanPipeline::take(TokenRingPtr& ring) {
+	// swap a drained ring for the next filled one, the drained
+	// one goes back into the queue to be filled again
+	size_t head = this->head.load(memory_order_relaxed);
+	if (this->tail.load(memory_order_acquire) == head) {
+		unique_lock<mutex> lock(this->wait_lock);
+		this->moved.wait(lock, [this, head]() {
+			return this->tail.load(memory_order_acquire) != head
+				|| this->finished.load(memory_order_acquire);
+		});
+	}
+	if (this->tail.load(memory_order_acquire) == head) {
+		// past the end of the input, every refill is just
+		// another end of file
+		ring->push(MP_EOF, this->eof_offset, 0, NameTable::no_name);
+		return;
+	}
+	Batch& batch = this->queue[head & (queue_size - 1)];
+	for (auto i = batch.names.begin(); i != batch.names.end(); i++) {
+		this->name_map.push_back(NameTable::global().intern(*i));
+	}
+	batch.ring->remap_names(this->name_map);
+	ring.swap(batch.ring);
+	this->head.store(head + 1, memory_order_release);
+	this->wake();
+}
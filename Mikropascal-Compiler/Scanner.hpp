@@ -4,79 +4,107 @@
 #include "Standard.hpp"
 #include "Input.hpp"
 #include "FiniteAutomata.hpp"
+#include "ScanKernels.hpp"
 #include "Tokens.hpp"
 #include "Helper.hpp"
 
 // makes this easier to read
 class Scanner;
+class ScanPipeline;
+struct ScannerTableFile;
 using ScannerPtr = shared_ptr<Scanner>;
-using ScanBufPtr = shared_ptr<vector<char>>;
-using ScanBuf = vector<char>;
+using ScanPipelinePtr = shared_ptr<ScanPipeline>;
+using ScannerTableFilePtr = shared_ptr<ScannerTableFile>;
 using TokenPtr = shared_ptr<Token>;
 using TokenList = vector<shared_ptr<Token>>;
 using TokenListPtr = shared_ptr<vector<shared_ptr<Token>>>;
 
+// scanner tables loaded from a binary file, the machine points
+// into the file's mapping, which lives as long as this does
+struct ScannerTableFile {
+	InputPtr file;
+	MachineTables machine;
+	vector<TokType> accept_kinds;
+};
+
+// the tokens an edit changed, removed tokens from first on in the
+// old stream were replaced by added tokens from first on in the new
+struct TokenSplice {
+	size_t first;
+	size_t removed;
+	size_t added;
+};
+
+// the keyword hash as it is built from the token info, before
+// it is baked into ScannerTables.hpp
+struct KeywordTable {
+	unsigned int min_length;
+	unsigned int max_length;
+	unsigned int factors[4];
+	vector<pair<string, TokType>> slots;
+};
+
 class Scanner {
+	friend class ScanPipeline;
 private:
-	// finite automata
-	FSMachineListPtr fsmachines;
-    
-    // accept detectors
-    bool some_accept();
-    bool none_accept();
-    
-    // reset and run commands
-    void reset_all_auto();
-    void run_all_auto(string input);
-    void run_chain();
+	// the DFA for every token pattern, baked in at build time (see
+	// ScannerTables.hpp), and the token type of each of its states
+	const MachineTables* scan_machine;
+	const TokType* accept_kinds;
+	
+	// tables loaded from a file instead, if any
+	ScannerTableFilePtr table_file;
+	
+	// characters a token can start with (or whitespace),
+	// where scanning picks up again after an error
+	bitset<256> token_starts;
+	void find_token_starts();
     
-    // accepting machine checks
-    FSMachineListPtr not_dead();
-    FSMachineListPtr accepting();
-    FSMachineListPtr run_buffer();
+    // vectorized skipping for whitespace, comments and strings
+    ScanKernels* kernels;
     
-    // loading finite automata
-	void load_keyword_machines();
-	void load_id_machine();
-	void load_num_machines();
-    void load_strand_machines(unsigned int nesting);
+    // declaring token patterns
+	static void load_keyword_patterns(RegexBuilder& patterns);
+	static void load_id_pattern(RegexBuilder& patterns);
+	static void load_num_patterns(RegexBuilder& patterns);
+    static void load_strand_patterns(RegexBuilder& patterns);
 	
-    // tokens
-	TokenListPtr consumed;
-    void consume(TokenPtr token);
-    TokenPtr last_token();
+    // tokens, and the names their identifiers are interned in
+	TokenStreamPtr tokens;
+	NameTable* names;
     TokenPtr create_token(TokType token, string lexeme,
     unsigned int line, unsigned int column);
 	
     // buffers
 	shared_ptr<Input> input_ptr;
-	StringPtr file_buf_ptr;
-	ScanBufPtr scan_buf;
-    string contents();
-    void clear_buffer();
-    
-    // shave commands
-    void shave_all();
-    void shave_buffer();
-    void shave_file_ptr();
-    void shave_chain();
+	SourceView file_buf;
     
     // pointers
-	string::iterator file_ptr;
+	const char* file_ptr;
 	void set_fp_begin();
-    string::iterator get_begin_fp();
-	string::iterator get_end_fp();
+    const char* get_begin_fp();
+	const char* get_end_fp();
 	
-    // line and column numbers
-	unsigned long line_number;
-	unsigned long col_number;
-    
     // scanner internal operations
-    TokenPtr scan_infinite();
-    TokenPtr scan_finite();
+    size_t scan_maximal();
+    size_t append_error(TokType error_tok, const char* token_start, size_t length);
+    void scan_remaining();
+    void report_scan_error(TokenStream& stream, size_t index);
+    
+    // how many bytes from its start scanning a token looked at
+    size_t scan_reach(size_t index);
+    
+    // parallel scanning, chunks are scanned by worker scanners
+    // with their own names that hold their errors until merged
+    Scanner(Scanner& parent, const char* first, const char* last);
+    unsigned int scan_threads;
+    NameTable chunk_names;
+    bool defer_errors;
+    vector<size_t> deferred_errors;
+    vector<const char*> find_chunk_cuts(size_t chunk_count);
     
     // debug set input string
-    void debug_set_input_string(StringPtr input);
+    void debug_set_input_string(string input);
     
 public:
     // constructors
@@ -86,6 +114,20 @@ public:
     // reset the scanner
 	void reset();
 	
+    // build the DFA from the token patterns, and write it out as
+    // the baked tables, or check the baked tables are current
+	static CompiledMachinePtr build_machine();
+	static vector<TokType> get_accept_kinds(CompiledMachinePtr machine);
+	static KeywordTable build_keywords();
+	static void write_tables(string filename);
+	static bool check_tables();
+	
+    // save the DFA as a binary table file, and load one to scan
+    // with in place of the baked tables (shareable by any scanner)
+	static void write_table_file(string filename);
+	static ScannerTableFilePtr load_table_file(string filename);
+	void set_table_file(ScannerTableFilePtr table_file);
+	
     // drop in replacements using DFAs
 	bool isalnum(char next);
 	bool isnum(char next);
@@ -96,11 +138,14 @@ public:
     
     // scan pointer (file pointer) movement
     void scan_all();
+    void scan_parallel(unsigned int thread_count);
 	TokenPtr scan_one();
+	size_t scan_next();
+	size_t refill(TokenRing& ring);
+	TokenSplice rescan(size_t offset, size_t length, const string& replacement);
+	void report_held_errors(TokenRing& ring);
 	int get_char();
     bool forward();
-	bool rewind();
-    void cache();
     void goto_next(char c);
     
     // useful scanning tools
@@ -109,7 +154,6 @@ public:
 	// get line and col numbers
 	unsigned long get_line_number();
 	unsigned long get_col_number();
-    unsigned long last_newline();
     
 	// display tokens on the screen
 	void display_tokens();
@@ -117,8 +161,53 @@ public:
     
 	// file ops
 	void write_tokens_tof(string filename);
+    void set_keep_comments(bool keep_comments);
+    void set_scan_threads(unsigned int thread_count);
     void thin_comments();
-	TokenListPtr detach_tokens();
+	TokenStreamPtr get_tokens();
+	InputPtr get_input();
+};
+
+// runs a scanner on its own thread, ahead of the parser. filled rings
+// of tokens go through a single producer single consumer queue, and
+// the parser swaps its drained ring for the next filled one. the
+// thread interns names into the scanner's own table, each batch
+// carries the names it added so the parser side can move its ids
+// over to the global table
+class ScanPipeline {
+private:
+	struct Batch {
+		TokenRingPtr ring;
+		vector<string> names;
+	};
+	enum { queue_size = 8 };
+	Batch queue[queue_size];
+	
+	// batches are filled at tail and taken at head, each side only
+	// writes its own counter. the thread stops after the batch that
+	// ends the input, whose end of file offset is kept for take
+	atomic<size_t> head;
+	atomic<size_t> tail;
+	atomic<bool> stopping;
+	atomic<bool> finished;
+	uint32_t eof_offset;
+	
+	// a side with nothing to do sleeps until the other moves its
+	// counter, the lock only guards the sleeping
+	mutex wait_lock;
+	condition_variable moved;
+	void wake();
+	
+	// the scanner's own name ids to global ones, parser side only
+	vector<uint32_t> name_map;
+	
+	ScannerPtr scanner;
+	thread producer;
+	void produce();
+public:
+	ScanPipeline(ScannerPtr scanner, size_t ring_capacity);
+	virtual ~ScanPipeline();
+	void take(TokenRingPtr& ring);
 };
 
 #endif
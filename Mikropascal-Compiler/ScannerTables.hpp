@@ -0,0 +1,183 @@
+#ifndef scanner_tables_h
+#define scanner_tables_h
+
+// generated by Scanner::write_tables from the token patterns in
+// Scanner.cpp, do not edit. run the driver with -g to regenerate
+
+#include "FiniteAutomata.hpp"
+#include "Tokens.hpp"
+
+static constexpr uint8_t scanner_byte_classes[256] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	2, 2, 2, 2, 2, 2, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+	12, 12, 12, 12, 12, 12, 12, 12, 12, 12, 13, 14, 15, 16, 17, 2,
+	2, 18, 18, 18, 18, 19, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18,
+	18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 2, 2, 2, 2, 20,
+	2, 18, 18, 18, 18, 19, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18,
+	18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 18, 21, 2, 22, 2, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static constexpr uint16_t scanner_table[690] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 17, 18, 19, 0,
+	0, 0, 2, 20, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 21, 0, 11, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 22, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 23, 24, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 25, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 17, 0, 0, 0, 0, 0, 17, 17, 18, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 17, 0, 0, 0, 0, 0, 17, 17, 0, 0, 0,
+	0, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 0, 26,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 21, 0, 0, 0, 0, 0, 0, 27, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 28, 0, 28, 0, 0, 29, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 29, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 29, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static constexpr uint32_t scanner_accept_bits[1] = {
+	670302200
+};
+
+static constexpr uint16_t scanner_accept_tags[30] = {
+	0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13,
+	14, 15, 0, 0, 16, 17, 18, 19, 20, 21, 22, 0, 0, 17
+};
+
+static constexpr MachineTables scanner_tables = {
+	30, 23,
+	scanner_byte_classes, scanner_table,
+	scanner_accept_bits, scanner_accept_tags
+};
+
+static constexpr TokType scanner_accept_kinds[30] = {
+	(TokType) 58, // MP_ERROR
+	(TokType) 58, // MP_ERROR
+	(TokType) 58, // MP_ERROR
+	(TokType) 4, // MP_LEFT_PAREN
+	(TokType) 5, // MP_RIGHT_PAREN
+	(TokType) 40, // MP_MULT
+	(TokType) 38, // MP_PLUS
+	(TokType) 2, // MP_COMMA
+	(TokType) 39, // MP_MINUS
+	(TokType) 6, // MP_PERIOD
+	(TokType) 41, // MP_DIV
+	(TokType) 48, // MP_INT_LITERAL
+	(TokType) 1, // MP_COLON
+	(TokType) 0, // MP_SEMI_COLON
+	(TokType) 28, // MP_LESSTHAN
+	(TokType) 27, // MP_EQUALS
+	(TokType) 29, // MP_GREATERTHAN
+	(TokType) 52, // MP_ID
+	(TokType) 58, // MP_ERROR
+	(TokType) 58, // MP_ERROR
+	(TokType) 50, // MP_STR_LITERAL
+	(TokType) 49, // MP_FLT_LITERAL
+	(TokType) 3, // MP_ASSIGNMENT
+	(TokType) 31, // MP_LESSTHAN_EQUALTO
+	(TokType) 32, // MP_NOT_EQUAL
+	(TokType) 30, // MP_GREATERTHAN_EQUALTO
+	(TokType) 56, // MP_COMMENT
+	(TokType) 58, // MP_ERROR
+	(TokType) 58, // MP_ERROR
+	(TokType) 49 // MP_FLT_LITERAL
+};
+
+static constexpr KeywordSlot scanner_keyword_slots[64] = {
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "end", (TokType) 12 },
+	{ "", (TokType) 52 },
+	{ "to", (TokType) 22 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "string", (TokType) 46 },
+	{ "", (TokType) 52 },
+	{ "program", (TokType) 7 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "writeln", (TokType) 16 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "read", (TokType) 13 },
+	{ "", (TokType) 52 },
+	{ "while", (TokType) 19 },
+	{ "else", (TokType) 26 },
+	{ "if", (TokType) 24 },
+	{ "var", (TokType) 10 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "mod", (TokType) 43 },
+	{ "integer", (TokType) 44 },
+	{ "", (TokType) 52 },
+	{ "div", (TokType) 42 },
+	{ "true", (TokType) 36 },
+	{ "procedure", (TokType) 8 },
+	{ "repeat", (TokType) 17 },
+	{ "begin", (TokType) 11 },
+	{ "write", (TokType) 15 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "float", (TokType) 45 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "for", (TokType) 21 },
+	{ "", (TokType) 52 },
+	{ "not", (TokType) 35 },
+	{ "false", (TokType) 37 },
+	{ "", (TokType) 52 },
+	{ "", (TokType) 52 },
+	{ "do", (TokType) 20 },
+	{ "or", (TokType) 33 },
+	{ "then", (TokType) 25 },
+	{ "readln", (TokType) 14 },
+	{ "downto", (TokType) 23 },
+	{ "", (TokType) 52 },
+	{ "boolean", (TokType) 47 },
+	{ "", (TokType) 52 },
+	{ "until", (TokType) 18 },
+	{ "function", (TokType) 9 },
+	{ "and", (TokType) 34 },
+	{ "", (TokType) 52 }
+};
+
+static constexpr KeywordHash scanner_keywords = {
+	2, 9,
+	{ 1, 1, 21, 61 },
+	scanner_keyword_slots
+};
+
+#endif
@@ -134,6 +134,10 @@ void SemanticAnalyzer::feed_token(TokenPtr token) {
 	this->block_stack->top()->catch_token(token);
 }
 
+void SemanticAnalyzer::feed_expression(ExpressionPtr expression) {
+	this->block_stack->top()->catch_expression(expression);
+}
+
 bool SemanticAnalyzer::is_data_in_callable(string data_id, string callable_id) {
 	// get all symbols and filter them
 	SymbolListPtr resolved_sym = this->get_symtable()->find(data_id);
@@ -217,96 +221,6 @@ void SemanticAnalyzer::close_file() {
 	this->file_writer.close();
 }
 
-bool CodeBlock::is_operator(SymbolPtr character) {
-	if (character->get_symbol_type() == SYM_CONSTANT) {
-		VarType op = static_pointer_cast<SymConstant>(character)->get_constant_type();
-		if (OPERATOR(op)()) {
-			return true;
-		}
-	}
-	return false;
-}
-
-bool CodeBlock::is_operand(SymbolPtr character) {
-	if (character->get_symbol_type() == SYM_CONSTANT) {
-		VarType op = static_pointer_cast<SymConstant>(character)->get_constant_type();
-		if (!OPERATOR(op)()
-			&& op != LPAREN
-			&& op != RPAREN) {
-			return true;
-		} else {
-			return false;
-		}
-	} else if (character->get_symbol_type() == SYM_DATA) {
-		return true;
-	} else {
-		return false;
-	}
-}
-
-bool CodeBlock::is_lparen(SymbolPtr character) {
-	VarType op = static_pointer_cast<SymConstant>(character)->get_constant_type();
-	if (op == LPAREN) {
-		return true;
-	} else {
-		return false;
-	}
-}
-
-bool CodeBlock::is_rparen(SymbolPtr character) {
-	VarType op = static_pointer_cast<SymConstant>(character)->get_constant_type();
-	if (op == RPAREN) {
-		return true;
-	} else {
-		return false;
-	}
-}
-
-bool CodeBlock::is_unary(SymbolPtr character) {
-	VarType op = static_pointer_cast<SymConstant>(character)->get_constant_type();
-	if (op == NOT) {
-		return true;
-	} else {
-		return false;
-	}
-}
-
-int CodeBlock::compare_ops(SymbolPtr c1, SymbolPtr c2) {
-	if (op_precendence(c1) > op_precendence(c2)) {
-		return 1;
-	} else if (op_precendence(c1) == op_precendence(c2)) {
-		return 0;
-	} else {
-		return -1;
-	}
-}
-
-int CodeBlock::op_precendence(SymbolPtr c1) {
-	if (c1 ->get_symbol_type() == SYM_CONSTANT) {
-		VarType op = static_pointer_cast<SymConstant>(c1)->get_constant_type();
-		if (op == LPAREN
-			|| op == RPAREN) {
-			return 4;
-		} else if (op == NOT) {
-			return 3;
-		} else if (op == DIV || op == MUL
-				   || op == MOD || op == AND) {
-			return 2;
-		} else if (op == ADD || op == SUB
-				   || op == OR) {
-			return 1;
-		} else if (op == IEQ || op == INE
-				   || op == ILT || op == ILE
-				   || op == IGT || op == IGE) {
-			return 0;
-		} else {
-			return -1;
-		}
-	} else {
-		return -1;
-	}
-}
-
 VarType CodeBlock::make_cast(SymbolPtr p, VarType v1, VarType v2) {
 	if (v1 != v2) {
 		if (v1 == INTEGER && v2 == FLOATING) {
@@ -396,6 +310,10 @@ void CodeBlock::catch_token(TokenPtr symbol) {
 	this->unprocessed->push_back(symbol);
 }
 
+void CodeBlock::catch_expression(ExpressionPtr expression) {
+	this->expressions->push_back(expression);
+}
+
 void CodeBlock::set_parent(CodeBlockPtr parent) {
 	this->parent_block = parent;
 }
@@ -412,118 +330,6 @@ void CodeBlock::preprocess() {
 	// do nothing
 }
 
-void CodeBlock::convert_postfix() {
-	// data structs
-	unique_ptr<stack<SymbolPtr>> op_stack = unique_ptr<stack<SymbolPtr>>(new stack<SymbolPtr>);
-	SymbolListPtr unpostfix_symbols = SymbolListPtr(new SymbolList());
-	
-	// shunting yard (modified for unary operators!)
-	for (auto i = this->temp_symbols->begin(); i !=
-		 this->temp_symbols->end(); i++) {
-		if (is_operand(*i)) {
-			unpostfix_symbols->push_back(*i);
-			if (!op_stack->empty()) {
-				if (is_unary(op_stack->top())) {
-					unpostfix_symbols->push_back(op_stack->top());
-					op_stack->pop();
-				}
-			}
-		} else if (is_operator(*i)) {
-			if (is_unary((*i))) {
-				op_stack->push(*i);
-			} else {
-				while (!op_stack->empty()
-					   && !is_lparen(op_stack->top())
-					   && compare_ops(*i, op_stack->top()) <= 0) {
-					unpostfix_symbols->push_back(op_stack->top());
-					op_stack->pop();
-				}
-				op_stack->push(*i);
-			}
-		} else if (is_lparen(*i)) {
-			op_stack->push(*i);
-		} else if (is_rparen(*i)) {
-			while (!op_stack->empty()) {
-				if (is_lparen(op_stack->top())) {
-					op_stack->pop();
-					if (!op_stack->empty()) {
-						if (is_unary(op_stack->top())) {
-							unpostfix_symbols->push_back(op_stack->top());
-							op_stack->pop();
-						}
-					}
-					break;
-				}
-				unpostfix_symbols->push_back(op_stack->top());
-				op_stack->pop();
-			}
-		}
-	}
-	while(!op_stack->empty()) {
-		unpostfix_symbols->push_back(op_stack->top());
-		op_stack->pop();
-	}
-	
-	// set the temp symbols as the postfix stuff
-	this->temp_symbols = unpostfix_symbols;
-}
-
-SymbolListPtr CodeBlock::convert_postfix(SymbolListPtr p) {
-	// data structs
-	unique_ptr<stack<SymbolPtr>> op_stack = unique_ptr<stack<SymbolPtr>>(new stack<SymbolPtr>);
-	SymbolListPtr unpostfix_symbols = SymbolListPtr(new SymbolList());
-	
-	// shunting yard (modified for unary operators!)
-	for (auto i = p->begin(); i !=
-		 p->end(); i++) {
-		if (is_operand(*i)) {
-			unpostfix_symbols->push_back(*i);
-			if (!op_stack->empty()) {
-				if (is_unary(op_stack->top())) {
-					unpostfix_symbols->push_back(op_stack->top());
-					op_stack->pop();
-				}
-			}
-		} else if (is_operator(*i)) {
-			if (is_unary((*i))) {
-				op_stack->push(*i);
-			} else {
-				while (!op_stack->empty()
-					   && !is_lparen(op_stack->top())
-					   && compare_ops(*i, op_stack->top()) <= 0) {
-					unpostfix_symbols->push_back(op_stack->top());
-					op_stack->pop();
-				}
-				op_stack->push(*i);
-			}
-		} else if (is_lparen(*i)) {
-			op_stack->push(*i);
-		} else if (is_rparen(*i)) {
-			while (!op_stack->empty()) {
-				if (is_lparen(op_stack->top())) {
-					op_stack->pop();
-					if (!op_stack->empty()) {
-						if (is_unary(op_stack->top())) {
-							unpostfix_symbols->push_back(op_stack->top());
-							op_stack->pop();
-						}
-					}
-					break;
-				}
-				unpostfix_symbols->push_back(op_stack->top());
-				op_stack->pop();
-			}
-		}
-	}
-	while(!op_stack->empty()) {
-		unpostfix_symbols->push_back(op_stack->top());
-		op_stack->pop();
-	}
-	
-	// set the temp symbols as the postfix stuff
-	return unpostfix_symbols;
-}
-
 // generates an expression
 // returns its last type
 VarType CodeBlock::generate_expr(SymbolListPtr expr_list) {
@@ -789,6 +595,27 @@ SymbolPtr CodeBlock::translate(TokenPtr token) {
 	}
 }
 
+SymbolListPtr CodeBlock::translate(ExpressionPtr expression) {
+	// the nodes are built operands first, so
+	// they are in postfix order already
+	SymbolListPtr postfix = SymbolListPtr(new SymbolList());
+	for (AbstractIndex i = 0; i < expression->size(); i++) {
+		SymbolPtr p = this->translate(expression->get_token(i));
+		if (p != nullptr) {
+			postfix->push_back(p);
+		}
+	}
+	return postfix;
+}
+
+void CodeBlock::translate_expressions() {
+	// append every caught expression to the symbol list
+	for (auto i = this->expressions->begin(); i != this->expressions->end(); i++) {
+		SymbolListPtr postfix = this->translate(*i);
+		this->temp_symbols->insert(this->temp_symbols->end(), postfix->begin(), postfix->end());
+	}
+}
+
 // Program Block stuff
 void ProgramBlock::generate_pre() {
 	// get the program id and set it as the open file
@@ -876,9 +703,8 @@ void AssignmentBlock::preprocess() {
 			}
 		}
 	}
-	// convert to postifx
-	if (this->get_valid() == true)
-		this->convert_postfix();
+	// the expression assigned
+	this->translate_expressions();
 }
 
 SymbolPtr AssignmentBlock::get_assigner() {
@@ -892,10 +718,9 @@ VarType AssignmentBlock::get_expr_type() {
 // IO Block stuff
 void IOBlock::generate_pre() {
 	if (this->action == IO_WRITE) {
-		for (auto i = this->expressions->begin();
-			 i != this->expressions->end(); i++) {
-			SymbolListPtr postfixes = this->convert_postfix(*i);
-			this->generate_expr(postfixes);
+		for (auto i = this->postfixes->begin();
+			 i != this->postfixes->end(); i++) {
+			this->generate_expr(*i);
 			write_raw("WRTS");
 		}
 	} else if (this->action == IO_READ) {
@@ -947,20 +772,11 @@ void IOBlock::preprocess() {
 	this->get_unprocessed()->erase(this->get_unprocessed()->begin());
 	this->get_unprocessed()->erase(this->get_unprocessed()->end() - 1);
 	if (this->action == IO_WRITE) {
-		SymbolListPtr pre = SymbolListPtr(new SymbolList());
-		for (auto i = this->get_unprocessed()->begin();
-			 i != this->get_unprocessed()->end(); i++) {
-			TokenPtr t = *i;
-			if (t->get_token() != MP_COMMA) {
-				SymbolPtr p = translate(t);
-				pre->push_back(p);
-			} else {
-				// reset
-				this->expressions->push_back(pre);
-				pre = SymbolListPtr(new SymbolList());
-			}
+		// one expression per parameter
+		for (auto i = this->get_expressions()->begin();
+			 i != this->get_expressions()->end(); i++) {
+			this->postfixes->push_back(this->translate(*i));
 		}
-		this->expressions->push_back(pre);
 	} else if (this->action == IO_READ) {
 		for (auto i = this->get_unprocessed()->begin();
 			 i != this->get_unprocessed()->end(); i++) {
@@ -993,9 +809,8 @@ void LoopBlock::generate_pre() {
 		// process the assignment
 		AssignmentBlockPtr assignment = AssignmentBlockPtr(new AssignmentBlock(false));
 		assignment->set_analyzer(this->get_analyzer());
-		for (auto i = 0; i < 3; i++) {
-			assignment->catch_token((*this->get_unprocessed())[i]);
-		}
+		assignment->catch_token((*this->get_unprocessed())[0]);
+		assignment->catch_expression((*this->get_expressions())[0]);
 		// generate its code
 		assignment->preprocess();
 		assignment->generate_pre();
@@ -1005,24 +820,23 @@ void LoopBlock::generate_pre() {
 		// process the ordinal expression
 		AssignmentBlockPtr ordinal_expr = AssignmentBlockPtr(new AssignmentBlock(true));
 		ordinal_expr->set_analyzer(this->get_analyzer());
-		for (unsigned int i = 4; i < this->get_unprocessed()->size(); i++) {
-			ordinal_expr->catch_token((*this->get_unprocessed())[i]);
-		}
+		ExpressionPtr ordinal = ExpressionPtr(new Expression(*(*this->get_expressions())[1]));
 		// get the comparison components for the ordinal expr
-		TokenPtr incrementer = (*this->get_unprocessed())[3];
-		if (incrementer->get_token() == MP_TO) {
-			ordinal_expr->catch_token(TokenPtr(new Token(MP_EQUALS, "=", -1, -1)));
-		} else if (incrementer->get_token() == MP_DOWNTO) {
-			ordinal_expr->catch_token(TokenPtr(new Token(MP_EQUALS, "=", -1, -1)));
-		}
-		ordinal_expr->catch_token((*this->get_unprocessed())[0]);
-		if (incrementer->get_token() == MP_TO) {
-			ordinal_expr->catch_token(TokenPtr(new Token (MP_MINUS, "-", -1, -1)));
-			ordinal_expr->catch_token(TokenPtr(new Token (MP_INT_LITERAL, "1", -1, -1)));
-		} else if (incrementer->get_token() == MP_DOWNTO) {
-			ordinal_expr->catch_token(TokenPtr(new Token (MP_PLUS, "+", -1, -1)));
-			ordinal_expr->catch_token(TokenPtr(new Token (MP_INT_LITERAL, "1", -1, -1)));
+		TokenPtr incrementer = this->get_incrementer();
+		if (incrementer != nullptr) {
+			// final value = control variable -/+ 1
+			AbstractIndex final_value = ordinal->get_root();
+			AbstractIndex control = ordinal->add_operand((*this->get_unprocessed())[0]);
+			AbstractIndex one = ordinal->add_operand(TokenPtr(new Token(MP_INT_LITERAL, "1", -1, -1)));
+			AbstractIndex step = 0;
+			if (incrementer->get_token() == MP_TO) {
+				step = ordinal->add_binary(TokenPtr(new Token(MP_MINUS, "-", -1, -1)), control, one);
+			} else {
+				step = ordinal->add_binary(TokenPtr(new Token(MP_PLUS, "+", -1, -1)), control, one);
+			}
+			ordinal->add_binary(TokenPtr(new Token(MP_EQUALS, "=", -1, -1)), final_value, step);
 		}
+		ordinal_expr->catch_expression(ordinal);
 		// generate its code
 		ordinal_expr->preprocess();
 		ordinal_expr->generate_pre();
@@ -1050,29 +864,26 @@ void LoopBlock::generate_post() {
 		write_raw(this->exit_label + ":\n");
 	} else if (this->type == FORLOOP) {
 		// get the incrementer token
-		TokenPtr incrementer = (*this->get_unprocessed())[3];
-		if (incrementer->get_token() == MP_TO) {
-			// generate an incrementer
+		TokenPtr incrementer = this->get_incrementer();
+		if (incrementer != nullptr) {
+			// control variable := control variable +/- 1
+			ExpressionPtr next = ExpressionPtr(new Expression());
+			AbstractIndex control = next->add_operand((*this->get_unprocessed())[0]);
+			AbstractIndex one = next->add_operand(TokenPtr(new Token(MP_INT_LITERAL, "1", -1, -1)));
+			if (incrementer->get_token() == MP_TO) {
+				// generate an incrementer
+				next->add_binary(TokenPtr(new Token(MP_PLUS, "+", -1, -1)), control, one);
+			} else {
+				// generate a decrementer
+				next->add_binary(TokenPtr(new Token(MP_MINUS, "-", -1, -1)), control, one);
+			}
 			AssignmentBlockPtr inc = AssignmentBlockPtr(new AssignmentBlock(false));
 			inc->set_analyzer(this->get_analyzer());
 			inc->catch_token((*this->get_unprocessed())[0]);
-			inc->catch_token((*this->get_unprocessed())[0]);
-			inc->catch_token(TokenPtr(new Token(MP_PLUS, "+", -1, -1)));
-			inc->catch_token(TokenPtr(new Token(MP_INT_LITERAL, "1", -1, -1)));
+			inc->catch_expression(next);
 			inc->preprocess();
 			inc->generate_pre();
 			inc->generate_post();
-		} else if (incrementer->get_token() == MP_DOWNTO) {
-			// generate a decrementer
-			AssignmentBlockPtr dec = AssignmentBlockPtr(new AssignmentBlock(false));
-			dec->set_analyzer(this->get_analyzer());
-			dec->catch_token((*this->get_unprocessed())[0]);
-			dec->catch_token((*this->get_unprocessed())[0]);
-			dec->catch_token(TokenPtr(new Token(MP_MINUS, "-", -1, -1)));
-			dec->catch_token(TokenPtr(new Token(MP_INT_LITERAL, "1", -1, -1)));
-			dec->preprocess();
-			dec->generate_pre();
-			dec->generate_post();
 		}
 		write_raw("BR " + this->cond_label + "\n");
 		write_raw(this->exit_label + ":\n");
@@ -1086,15 +897,21 @@ void LoopBlock::preprocess() {
 	if (this->type == WHILELOOP
 		|| this->type == RPTUNTLLOOP) {
 		// process the boolean statement
-		for (auto i = this->get_unprocessed()->begin();
-			 i != this->get_unprocessed()->end(); i++) {
-			this->get_symbol_list()->push_back(this->translate(*i));
-		}
-		if (this->get_valid() == true)
-			this->convert_postfix();
+		this->translate_expressions();
 	}
 }
 
+TokenPtr LoopBlock::get_incrementer() {
+	// to or downto, after the control variable and :=
+	TokenListPtr tokens = this->get_unprocessed();
+	if (tokens->size() > 2
+		&& ((*tokens)[2]->get_token() == MP_TO
+			|| (*tokens)[2]->get_token() == MP_DOWNTO)) {
+		return (*tokens)[2];
+	}
+	return nullptr;
+}
+
 void LoopBlock::catch_token(TokenPtr symbol) {
 	if (symbol->get_token() != MP_WHILE
 		&& symbol->get_token() != MP_REPEAT
@@ -1136,12 +953,8 @@ void ConditionalBlock::preprocess() {
 			}
 		}
 	}
-	for (auto i = this->get_unprocessed()->begin();
-		 i != this->get_unprocessed()->end(); i++) {
-		this->get_symbol_list()->push_back(this->translate(*i));
-	}
-	if (this->get_valid())
-		this->convert_postfix();
+	// the condition, if any
+	this->translate_expressions();
 }
 
 void ConditionalBlock::generate_pre() {
@@ -1336,6 +1149,7 @@ void ActivationBlock::preprocess() {
 			 i != this->get_unprocessed()->end(); i++) {
 			this->get_symbol_list()->push_back(this->translate(*i));
 		}
+		this->translate_expressions();
 	}
 }
 
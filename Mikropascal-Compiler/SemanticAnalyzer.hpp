@@ -63,6 +63,7 @@ private:
 	CodeBlockListPtr block_list;
 	BlockType block_type;
 	TokenListPtr unprocessed;
+	ExpressionListPtr expressions;
 	SymbolListPtr temp_symbols;
 	CodeBlockPtr parent_block;
 	SemanticAnalyzerPtr parent_analyzer;
@@ -72,6 +73,7 @@ public:
 	block_type(block_type), parent_block(parent_block){
 		this->block_list = CodeBlockListPtr(new CodeBlockList());
 		this->unprocessed = TokenListPtr(new TokenList());
+		this->expressions = ExpressionListPtr(new ExpressionList());
 		this->parent_analyzer = nullptr;
 		this->temp_symbols = SymbolListPtr(new SymbolList());
 		this->valid = true;
@@ -80,6 +82,7 @@ public:
 	CodeBlockListPtr get_block_list() { return this->block_list; }
 	BlockType get_block_type() { return this->block_type; }
 	TokenListPtr get_unprocessed() { return this->unprocessed; }
+	ExpressionListPtr get_expressions() { return this->expressions; }
 	SymbolListPtr get_symbol_list() { return this->temp_symbols; }
 	void set_symbol_list(SymbolListPtr p) { this->temp_symbols = p; }
 	CodeBlockPtr get_parent_block() { return this->parent_block; }
@@ -91,20 +94,12 @@ public:
 	virtual void preprocess();
 	virtual bool validate();
 	virtual void catch_token(TokenPtr symbol);
+	virtual void catch_expression(ExpressionPtr expression);
 	void append(CodeBlockPtr block);
 	void set_parent(CodeBlockPtr parent);
 	void set_analyzer(SemanticAnalyzerPtr analyzer);
 	unsigned int get_nesting_level();
 	bool check_filter_size(SymbolListPtr filtered);
-	static bool is_operator(SymbolPtr character);
-	static bool is_operand(SymbolPtr character);
-	static bool is_lparen(SymbolPtr character);
-	static bool is_rparen(SymbolPtr character);
-	static bool is_unary(SymbolPtr character);
-	static int compare_ops(SymbolPtr c1, SymbolPtr c2);
-	static int op_precendence(SymbolPtr c1);
-	SymbolListPtr convert_postfix(SymbolListPtr p);
-	void convert_postfix();
 	void emit(InstructionType ins, vector<string> operands);
 	VarType make_cast(SymbolPtr p, VarType v1, VarType v2);
 	VarType generate_expr(SymbolListPtr expr_list);
@@ -112,6 +107,8 @@ public:
 	CodeBlockList::iterator inner_begin();
 	CodeBlockList::iterator inner_end();
 	SymbolPtr translate(TokenPtr token);
+	SymbolListPtr translate(ExpressionPtr expression);
+	void translate_expressions();
 	void write_raw(string raw);
 };
 
@@ -132,12 +129,12 @@ enum IOAction {
 
 class IOBlock: public CodeBlock {
 private:
-	shared_ptr<vector<SymbolListPtr>> expressions;
+	shared_ptr<vector<SymbolListPtr>> postfixes;
 	IOAction action;
 	bool line_terminator;
 public:
 	IOBlock(IOAction action, bool newline): CodeBlock(IO_BLOCK, nullptr), action(action), line_terminator(newline) {
-		this->expressions = shared_ptr<vector<SymbolListPtr>>(new vector<SymbolListPtr>);
+		this->postfixes = shared_ptr<vector<SymbolListPtr>>(new vector<SymbolListPtr>);
 	}
 	~IOBlock() = default;
 	virtual void generate_pre();
@@ -172,6 +169,7 @@ public:
 	virtual void preprocess();
 	virtual void catch_token(TokenPtr symbol);
 	virtual bool validate();
+	TokenPtr get_incrementer();
 };
 
 enum CondType {
@@ -311,6 +309,7 @@ public:
 	void generate_all();
 	void generate_one(CodeBlockPtr current);
 	void feed_token(TokenPtr token);
+	void feed_expression(ExpressionPtr expression);
 	void append_block(CodeBlockPtr new_block);
 	void rappel_block();
 	void write_tof(string raw);
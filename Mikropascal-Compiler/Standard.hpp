@@ -10,6 +10,7 @@
 #include <sstream>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <fstream>
 #include <stack>
@@ -18,6 +19,12 @@
 #include <locale>
 #include <typeinfo>
 #include <limits>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <random>
 
 // all C derived includes here
 #include <cassert>
@@ -27,6 +34,7 @@
 #include <cstring>
 #include <cctype>
 #include <climits>
+#include <cstdint>
 
 // use the standard namespace
 using namespace std;
@@ -36,5 +44,10 @@ using StringPtr = shared_ptr<string>;
 
 // defines
 #define DEBUG_OUTPUT 0
+// record parser events into a ring buffer (ParseTrace.hpp),
+// turned on with -DPARSE_TRACE=1
+#ifndef PARSE_TRACE
+#define PARSE_TRACE 0
+#endif
 
 #endif
@@ -1,120 +1,170 @@
 #include "SyntaxTree.hpp"
 
 AbstractTree::AbstractTree() {
-	this->root_node = AbstractNodePtr(new AbstractNode());
-	this->iterable = this->root_node;
+	this->clear();
+}
+
+AbstractIndex AbstractTree::add_node(ParseType parse_type, AbstractIndex token_index) {
+	// append a node as the last child of the current one
+	AbstractIndex index = (AbstractIndex) this->nodes.size();
+	this->nodes.push_back(AbstractNode(parse_type, token_index, this->iterable));
+	if (this->iterable != AbstractNode::no_node) {
+		AbstractNode& parent = this->nodes[this->iterable];
+		if (parent.last_child == AbstractNode::no_node) {
+			parent.first_child = index;
+		} else {
+			this->nodes[parent.last_child].next_sibling = index;
+		}
+		parent.last_child = index;
+	}
+	return index;
 }
 
-AbstractTree::AbstractTree(AbstractNodePtr root) {
-	this->root_node = root;
-	this->iterable = this->root_node;
+void AbstractTree::add_move_child(ParseType parse_type) {
+	this->iterable = this->add_node(parse_type, AbstractNode::no_node);
 }
 
-void AbstractTree::add_move_child(AbstractNodePtr child_node) {
-	this->iterable->add_child_node(child_node);
-	child_node->set_parent(this->iterable);
-	this->iterable = child_node;
+void AbstractTree::add_move_child(const Token& token, const InputPtr& input) {
+	if (this->input != input) {
+		this->input = input;
+	}
+	this->tokens.push_back(token);
+	this->iterable = this->add_node(LITERAL, (AbstractIndex) this->tokens.size() - 1);
 }
 
 void AbstractTree::goto_parent() {
-	if (this->iterable->get_parent() != nullptr) {
-		this->iterable = this->iterable->get_parent();
+	if (this->nodes[this->iterable].parent_node != AbstractNode::no_node) {
+		this->iterable = this->nodes[this->iterable].parent_node;
 	}
 }
 
-void AbstractTree::push_children(AbstractNodePtr current_node, AbstractStackPtr current_symbols) {
-	AbstractStackPtr reversal = AbstractStackPtr(new AbstractNodeStack());
-	for (auto i = current_node->get_child_begin();
-		i != current_node->get_child_end(); i++) {
-		reversal->push(*i);
-	}
-	while (!reversal->empty()) {
-		current_symbols->push(reversal->top());
-		reversal->pop();
-	}
+void AbstractTree::clear() {
+	// drop every node at once, leaving just the root
+	this->nodes.clear();
+	this->tokens.clear();
+	this->input = nullptr;
+	this->iterable = AbstractNode::no_node;
+	this->iterable = this->add_node(ROOT, AbstractNode::no_node);
 }
 
-AbstractNodePtr AbstractTree::get_root_node() {
+AbstractIndex AbstractTree::get_root_node() {
 	return this->iterable;
 }
 
-AbstractNodePtr AbstractTree::get_current_parent() {
-	if (this->iterable->get_parent() != nullptr) {
-		return this->iterable->get_parent();
-	}
-	return nullptr;
+AbstractNode& AbstractTree::get_node(AbstractIndex index) {
+	return this->nodes[index];
+}
+
+Token* AbstractTree::get_token(AbstractIndex index) {
+	AbstractIndex token_index = this->nodes[index].token_index;
+	return (token_index == AbstractNode::no_node) ? nullptr : &this->tokens[token_index];
+}
+
+size_t AbstractTree::size() {
+	return this->nodes.size();
 }
 
 void AbstractTree::display_tree() {
-	// display tree at the root, which is where it should be
+	// display tree at the root, which is where it should be. the
+	// walk is in preorder, down to the first child, else over to
+	// the next sibling of the nearest node that has one
 	report_msg("Printable AST: ");
-	AbstractStackPtr loop = AbstractStackPtr(new AbstractNodeStack());
-	loop->push(this->iterable);
-	while (!loop->empty()) {
-		AbstractNodePtr current = loop->top();
-		loop->pop();
-		if (current->get_is_rule()) {
+	AbstractIndex top = this->iterable;
+	AbstractIndex current = top;
+	while (current != AbstractNode::no_node) {
+		AbstractNode& node = this->nodes[current];
+		if (node.get_is_rule()) {
 			report_msg_type("AST Rule",
-				get_rule_info(current->get_parse_type()));
-			this->push_children(current, loop);
+				get_rule_info(node.get_parse_type()));
 		}
-		else if (current->get_is_epsilon()) {
+		else if (node.get_is_epsilon()) {
 			report_msg("AST Epsilon");
 		}
 		else {
+			Token* token = this->get_token(current);
 			report_msg_type("AST Match",
-				get_token_info(current->get_token()->get_token()).first
-				+ ": " + current->get_token()->get_lexeme());
+				get_token_info(token->get_token()).first
+				+ ": " + token->get_lexeme());
 		}
+		if (node.get_is_rule() && node.first_child != AbstractNode::no_node) {
+			current = node.first_child;
+			continue;
+		}
+		while (current != top && this->nodes[current].next_sibling == AbstractNode::no_node) {
+			current = this->nodes[current].parent_node;
+		}
+		current = (current == top) ? AbstractNode::no_node : this->nodes[current].next_sibling;
 	}
 }
 
-AbstractNode::AbstractNode() {
-	this->child_nodes = AbstractListPtr(new AbstractNodeList());
-	this->parse_type = ROOT;
-	this->is_root = true;
-	this->is_rule = true;
-	this->token = nullptr;
-}
-
-AbstractNode::AbstractNode(ParseType parse_type) {
-	this->child_nodes = AbstractListPtr(new AbstractNodeList());
-	this->parse_type = parse_type;
-	this->is_root = false;
-	this->is_rule = true;
-	this->token = nullptr;
-}
-
-AbstractNode::AbstractNode(AbstractNodePtr parent_node, ParseType parse_type) {
-	this->child_nodes = AbstractListPtr(new AbstractNodeList());
-	this->parse_type = parse_type;
-	this->is_root = false;
-	this->is_rule = true;
-	this->token = nullptr;
-}
-
-AbstractNode::AbstractNode(TokenPtr token) {
-	this->child_nodes = nullptr;
-	this->parse_type = LITERAL;
-	this->is_root = false;
-	this->is_rule = false;
-	this->token = token;
+FlatTreePtr AbstractTree::flatten() {
+	// flatten from the current node, the root once parsing is done
+	return FlatTreePtr(new FlatTree(*this, this->iterable));
+}
+
+FlatTree::FlatTree(AbstractTree& tree, AbstractIndex top) {
+	// copy the subtree under top in preorder. the entries of the
+	// nodes being walked through stay open until the walk climbs
+	// back out of them, when their subtree size is known
+	this->nodes.reserve(tree.nodes.size());
+	this->tokens = tree.tokens;
+	this->input = tree.input;
+	vector<size_t> open;
+	AbstractIndex current = top;
+	while (current != AbstractNode::no_node) {
+		AbstractNode& node = tree.nodes[current];
+		open.push_back(this->nodes.size());
+		this->nodes.push_back(FlatNode { (uint8_t) (node.get_is_rule() ? node.get_parse_type() : LITERAL),
+										  node.get_token_index(), 1 });
+		if (node.get_first_child() != AbstractNode::no_node) {
+			current = node.get_first_child();
+			continue;
+		}
+		while (true) {
+			size_t closed = open.back();
+			open.pop_back();
+			this->nodes[closed].subtree_size = (AbstractIndex) (this->nodes.size() - closed);
+			if (current == top || tree.nodes[current].get_next_sibling() != AbstractNode::no_node) {
+				break;
+			}
+			current = tree.nodes[current].get_parent();
+		}
+		current = (current == top) ? AbstractNode::no_node : tree.nodes[current].get_next_sibling();
+	}
 }
 
-void AbstractNode::add_child_node(AbstractNodePtr child_node) {
-	this->child_nodes->push_back(child_node);
+void FlatTree::display_tree() {
+	// same listing as the tree it came from, in one pass
+	report_msg("Printable AST: ");
+	this->visit(0, [this](size_t i) {
+		if (this->get_is_rule(i)) {
+			report_msg_type("AST Rule",
+				get_rule_info(this->get_parse_type(i)));
+		}
+		else {
+			Token* token = this->get_token(i);
+			report_msg_type("AST Match",
+				get_token_info(token->get_token()).first
+				+ ": " + token->get_lexeme());
+		}
+	});
 }
 
-void AbstractNode::set_is_root(bool is_root) {
-	this->is_root = is_root;
+AbstractNode::AbstractNode(ParseType parse_type, AbstractIndex token_index, AbstractIndex parent_node) {
+	this->parse_type = (uint8_t) parse_type;
+	this->token_index = token_index;
+	this->parent_node = parent_node;
+	this->first_child = no_node;
+	this->last_child = no_node;
+	this->next_sibling = no_node;
 }
 
 bool AbstractNode::get_is_root() {
-	return this->is_root;
+	return this->parse_type == ROOT;
 }
 
 bool AbstractNode::get_is_rule() {
-	return this->is_rule;
+	return this->parse_type != LITERAL;
 }
 
 bool AbstractNode::get_is_epsilon() {
@@ -122,38 +172,75 @@ bool AbstractNode::get_is_epsilon() {
 }
 
 ParseType AbstractNode::get_parse_type() {
-	if (this->is_rule != false)
-		return this->parse_type;
+	if (this->get_is_rule())
+		return (ParseType) this->parse_type;
 	else
 		return NO_RULE;
 }
 
-TokenPtr AbstractNode::get_token() {
-	if (is_rule) {
-		return nullptr;
-	}
-	else {
-		return this->token;
-	}
+AbstractIndex AbstractNode::get_token_index() {
+	return this->token_index;
 }
 
-void AbstractNode::set_parent(AbstractNodePtr new_parent_node) {
-	this->parent_node = new_parent_node;
+AbstractIndex AbstractNode::get_parent() {
+	return this->parent_node;
 }
 
-AbstractNodePtr AbstractNode::get_parent() {
-	if (this->parent_node == nullptr) {
-		return nullptr;
-	}
-	else {
-		return this->parent_node;
-	}
+AbstractIndex AbstractNode::get_first_child() {
+	return this->first_child;
+}
+
+AbstractIndex AbstractNode::get_next_sibling() {
+	return this->next_sibling;
+}
+AbstractIndex Expression::add_node(ExpressionKind kind, TokenPtr token, AbstractIndex left, AbstractIndex right) {
+	AbstractIndex index = (AbstractIndex) this->nodes.size();
+	this->nodes.push_back(ExpressionNode { kind, left, right });
+	this->tokens.push_back(token);
+	return index;
+}
+
+AbstractIndex Expression::add_operand(TokenPtr token) {
+	return this->add_node(OPERAND, token, AbstractNode::no_node, AbstractNode::no_node);
+}
+
+AbstractIndex Expression::add_unary(TokenPtr op, AbstractIndex operand) {
+	return this->add_node(UNARY, op, operand, AbstractNode::no_node);
+}
+
+AbstractIndex Expression::add_binary(TokenPtr op, AbstractIndex left, AbstractIndex right) {
+	return this->add_node(BINARY, op, left, right);
+}
+
+AbstractIndex Expression::get_root() {
+	return this->nodes.empty() ? AbstractNode::no_node : (AbstractIndex) this->nodes.size() - 1;
+}
+
+ExpressionKind Expression::get_kind(AbstractIndex index) {
+	return this->nodes[index].kind;
+}
+
+AbstractIndex Expression::get_left(AbstractIndex index) {
+	return this->nodes[index].left;
 }
 
-AbstractNodeList::iterator AbstractNode::get_child_begin() {
-	return this->child_nodes->begin();
+AbstractIndex Expression::get_right(AbstractIndex index) {
+	return this->nodes[index].right;
 }
 
-AbstractNodeList::iterator AbstractNode::get_child_end() {
-	return this->child_nodes->end();
-}
\ No newline at end of file
+TokenPtr Expression::get_token(AbstractIndex index) {
+	return this->tokens[index];
+}
+
+size_t Expression::size() {
+	return this->nodes.size();
+}
+
+void Expression::display_tree() {
+	// the nodes in postfix order, as they are evaluated
+	string postfix = "";
+	for (auto i = this->tokens.begin(); i != this->tokens.end(); i++) {
+		postfix += (*i)->get_lexeme() + " ";
+	}
+	report_msg_type("Expression", postfix);
+}
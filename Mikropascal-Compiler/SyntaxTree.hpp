@@ -8,60 +8,151 @@
 
 class AbstractNode;
 class AbstractTree;
+class FlatTree;
+class Expression;
 
-using AbstractNodePtr = shared_ptr<AbstractNode>;
-using AbstractNodeList = vector<AbstractNodePtr>;
-using AbstractListPtr = shared_ptr<AbstractNodeList>;
-using AbstractNodeStack = stack<AbstractNodePtr>;
-using AbstractStackPtr = shared_ptr<AbstractNodeStack>;
+using AbstractIndex = uint32_t;
 using AbstractTreePtr = shared_ptr<AbstractTree>;
+using FlatTreePtr = shared_ptr<FlatTree>;
+using ExpressionPtr = shared_ptr<Expression>;
+using ExpressionList = vector<ExpressionPtr>;
+using ExpressionListPtr = shared_ptr<ExpressionList>;
 using TokenPtr = shared_ptr<Token>;
 using TokenList = vector<TokenPtr>;
 using TokenListPtr = shared_ptr<TokenList>;
 
+// a node of the tree, living in its tree's arena. nodes refer
+// to each other by their index in the arena
 class AbstractNode {
 private:
-	bool is_root;
-	bool is_rule;
-	AbstractNodePtr parent_node;
-	AbstractListPtr child_nodes;
-	ParseType parse_type;
-	TokenPtr token;
+	uint8_t parse_type;
+	AbstractIndex token_index;
+	AbstractIndex parent_node;
+	AbstractIndex first_child;
+	AbstractIndex last_child;
+	AbstractIndex next_sibling;
 public:
-	AbstractNode();
-	AbstractNode(AbstractNodePtr parent_node, ParseType parse_type);
-	AbstractNode(ParseType parse_type);
-	AbstractNode(TokenPtr token);
-	virtual ~AbstractNode() = default;
-	void add_child_node(AbstractNodePtr child_node);
-	void set_is_root(bool is_root);
-	void set_parent(AbstractNodePtr parent_node);
+	enum Index : AbstractIndex { no_node = UINT32_MAX };
+	AbstractNode(ParseType parse_type, AbstractIndex token_index, AbstractIndex parent_node);
 	bool get_is_root();
 	bool get_is_rule();
 	bool get_is_epsilon();
 	ParseType get_parse_type();
-	TokenPtr get_token();
-	AbstractNodePtr get_parent();
-	AbstractNodeList::iterator get_child_begin();
-	AbstractNodeList::iterator get_child_end();
+	AbstractIndex get_token_index();
+	AbstractIndex get_parent();
+	AbstractIndex get_first_child();
+	AbstractIndex get_next_sibling();
+	friend class AbstractTree;
 };
 
+// the tree owns every node in one arena, and the tokens of the literal
+// nodes beside it by value, so it is released all at once. it keeps
+// the input its tokens point into alive
 class AbstractTree {
 private:
-	AbstractNodePtr root_node;
-	AbstractNodePtr iterable;
-	AbstractNodePtr get_current_parent();
-	void display_tree_rec();
+	vector<AbstractNode> nodes;
+	vector<Token> tokens;
+	InputPtr input;
+	AbstractIndex iterable;
+	AbstractIndex add_node(ParseType parse_type, AbstractIndex token_index);
 public:
 	AbstractTree();
-	AbstractTree(AbstractNodePtr root);
 	virtual ~AbstractTree() = default;
-	void add_move_child(AbstractNodePtr child_node);
+	void add_move_child(ParseType parse_type);
+	void add_move_child(const Token& token, const InputPtr& input);
 	void goto_parent();
 	void display_tree();
-	void push_children(AbstractNodePtr current_node,
-		AbstractStackPtr current_symbols);
-	AbstractNodePtr get_root_node();
+	void clear();
+	AbstractIndex get_root_node();
+	AbstractNode& get_node(AbstractIndex index);
+	Token* get_token(AbstractIndex index);
+	size_t size();
+	FlatTreePtr flatten();
+	friend class FlatTree;
+};
+
+// a read only copy of a tree as one preorder array. each entry holds
+// the size of its subtree, so the entry after a subtree is a fixed
+// distance away and passes over the tree are a linear scan
+class FlatTree {
+private:
+	struct FlatNode {
+		uint8_t parse_type;
+		AbstractIndex token_index;
+		AbstractIndex subtree_size;
+	};
+	vector<FlatNode> nodes;
+	vector<Token> tokens;
+	InputPtr input;
+public:
+	FlatTree(AbstractTree& tree, AbstractIndex top);
+	virtual ~FlatTree() = default;
+	size_t size() {
+		return this->nodes.size();
+	}
+	ParseType get_parse_type(size_t index) {
+		return (ParseType) this->nodes[index].parse_type;
+	}
+	bool get_is_rule(size_t index) {
+		return this->nodes[index].parse_type != LITERAL;
+	}
+	AbstractIndex get_subtree_size(size_t index) {
+		return this->nodes[index].subtree_size;
+	}
+	size_t skip(size_t index) {
+		// the entry just past this one's subtree
+		return index + this->nodes[index].subtree_size;
+	}
+	Token* get_token(size_t index) {
+		AbstractIndex token_index = this->nodes[index].token_index;
+		return (token_index == AbstractNode::no_node) ? nullptr : &this->tokens[token_index];
+	}
+	template <typename Visitor> void visit(size_t index, Visitor visitor) {
+		// call the visitor on every entry of a subtree in preorder
+		for (size_t i = index; i < this->skip(index); i++) {
+			visitor(i);
+		}
+	}
+	void display_tree();
+};
+
+// what a node of an expression is
+enum ExpressionKind : uint8_t {
+	// an identifier or a literal
+	OPERAND,
+	// not, on one operand
+	UNARY,
+	// an operator on a left and a right operand
+	BINARY
+};
+
+// an expression as the precedence parser builds it, one node per
+// operand or operator. a node is only added after its operands, so
+// the arena in order is already the postfix form code is generated
+// from, and the root is always the last node
+class Expression {
+private:
+	struct ExpressionNode {
+		ExpressionKind kind;
+		AbstractIndex left;
+		AbstractIndex right;
+	};
+	vector<ExpressionNode> nodes;
+	vector<TokenPtr> tokens;
+	AbstractIndex add_node(ExpressionKind kind, TokenPtr token, AbstractIndex left, AbstractIndex right);
+public:
+	Expression() = default;
+	virtual ~Expression() = default;
+	AbstractIndex add_operand(TokenPtr token);
+	AbstractIndex add_unary(TokenPtr op, AbstractIndex operand);
+	AbstractIndex add_binary(TokenPtr op, AbstractIndex left, AbstractIndex right);
+	AbstractIndex get_root();
+	ExpressionKind get_kind(AbstractIndex index);
+	AbstractIndex get_left(AbstractIndex index);
+	AbstractIndex get_right(AbstractIndex index);
+	TokenPtr get_token(AbstractIndex index);
+	size_t size();
+	void display_tree();
 };
 
 #endif
\ No newline at end of file
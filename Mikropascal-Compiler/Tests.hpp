@@ -71,6 +71,88 @@ int automata_test_cases() {
 	return 0;
 }
 
+int automata_compile_test_cases() {
+	cout << "[ Automata Compile Tests ]" << endl;
+	
+	// two words that share a suffix, the suffix states merge
+	FSMachineListPtr machines = FSMachineListPtr(new vector<FSMachinePtr>);
+	machines->push_back(FSMachinePtr(new FiniteMachineContainer("MP_WORD", true)));
+	machines->push_back(FSMachinePtr(new FiniteMachineContainer("MP_WORD", true)));
+	(*machines)[0]->build_keyword("read");
+	(*machines)[1]->build_keyword("thread");
+	CompiledMachinePtr compiled = FiniteMachineContainer::combine("MP_WORDS", machines)->compile();
+	cout << "States: " << compiled->get_state_count()
+		 << " Classes: " << compiled->get_class_count() << endl;
+	
+	// accepts or rejects?
+	vector<string> test_strings = { "read", "READ", "thread", "tread", "readthread" };
+	for (vector<string>::iterator i = test_strings.begin();
+		 i != test_strings.end(); i++) {
+		compiled->run(*i);
+		cout << (compiled->accepting() ? "Accepted as " + compiled->accepting_name() : "Rejected.") << endl;
+		compiled->reset();
+	}
+	cout << "[ End ]" << endl;
+	return 0;
+}
+
+int automata_regex_test_cases() {
+	cout << "[ Automata Regex Tests ]" << endl;
+	
+	// the keyword beats the identifier on a tie
+	RegexBuilder builder;
+	builder.add_token("MP_ID", "[a-z_]+", 2);
+	builder.add_token("MP_IF", "if", 1);
+	builder.add_token("MP_NUM", "[0-9]+(\\.[0-9]*)?", 1);
+	CompiledMachinePtr compiled = builder.build();
+	cout << "States: " << compiled->get_state_count()
+		 << " Classes: " << compiled->get_class_count() << endl;
+	
+	// accepts or rejects?
+	vector<string> test_strings = { "if", "iffy", "x_1", "12", "12.5", "." };
+	for (vector<string>::iterator i = test_strings.begin();
+		 i != test_strings.end(); i++) {
+		compiled->run(*i);
+		cout << (compiled->accepting() ? "Accepted as " + compiled->accepting_name() : "Rejected.") << endl;
+		compiled->reset();
+	}
+	cout << "[ End ]" << endl;
+	return 0;
+}
+
+int scanner_tables_test() {
+	cout << "[ Scanner Tables Test ]" << endl;
+	
+	// the baked tables go stale when a token pattern changes
+	if (Scanner::check_tables()) {
+		cout << "Baked tables match the token patterns." << endl;
+	} else {
+		cout << "Baked tables are stale, regenerate them with -g." << endl;
+	}
+	cout << "[ End ]" << endl;
+	return 0;
+}
+
+int scanner_table_file_test(string table_filename, string filename) {
+	cout << "[ Scanner Table File Test ]" << endl;
+	
+	// write the tables out, then scan with them loaded back in
+	Scanner::write_table_file(table_filename);
+	ScannerTableFilePtr table_file = Scanner::load_table_file(table_filename);
+	InputPtr input = Input::open_file(filename);
+	if (table_file == nullptr || input == nullptr) {
+		return -1;
+	}
+	cout << "States: " << table_file->machine.num_states
+		 << " Classes: " << table_file->machine.num_classes << endl;
+	ScannerPtr scanner = ScannerPtr(new Scanner(input));
+	scanner->set_table_file(table_file);
+	scanner->scan_all();
+	scanner->display_tokens();
+	cout << "[ End ]" << endl;
+	return 0;
+}
+
 int input_test_cases(string path) {
 	cout << "[ Input Tests ]" << endl;
 	shared_ptr<Input> test_input = Input::open_file(path);
@@ -84,6 +166,7 @@ int scanner_test(string filename) {
 	shared_ptr<Input> test_input = Input::open_file(filename);
     if (test_input != nullptr) {
         shared_ptr<Scanner> scanner = shared_ptr<Scanner>(new Scanner(test_input));
+        scanner->set_keep_comments(true);
         TokenPtr t;
         do {
             t = scanner->scan_one();
@@ -99,6 +182,43 @@ int scanner_test(string filename) {
 	return 0;
 }
 
+int scanner_rescan_test(string filename, size_t offset, size_t length, string replacement) {
+	cout << "[ Scanner Rescan Test ]" << endl;
+	
+	// edit a scanned file, then check the spliced stream against a
+	// scan of the edited text from scratch
+	InputPtr input = Input::open_file(filename);
+	if (input == nullptr) {
+		return -1;
+	}
+	ScannerPtr scanner = ScannerPtr(new Scanner(input));
+	scanner->scan_all();
+	TokenSplice splice = scanner->rescan(offset, length, replacement);
+	
+	// an edit that changes anything scans at least one new token
+	if (splice.added == 0 && (length > 0 || !replacement.empty())) {
+		cout << "The edit was refused, the input is unchanged." << endl;
+		cout << "[ End ]" << endl;
+		return -1;
+	}
+	cout << "First: " << splice.first << " Removed: " << splice.removed
+		 << " Added: " << splice.added << endl;
+	ScannerPtr fresh = ScannerPtr(new Scanner(Input::open_string(scanner->get_input()->get_view().to_string())));
+	fresh->scan_all();
+	TokenStreamPtr edited = scanner->get_tokens();
+	TokenStreamPtr expected = fresh->get_tokens();
+	bool same = edited->size() == expected->size();
+	for (size_t i = 0; same && i < edited->size(); i++) {
+		same = edited->get_kind(i) == expected->get_kind(i)
+			&& edited->get_offset(i) == expected->get_offset(i)
+			&& edited->get_length(i) == expected->get_length(i)
+			&& edited->get_lexeme(i) == expected->get_lexeme(i);
+	}
+	cout << (same ? "Matches a full scan." : "Differs from a full scan!") << endl;
+	cout << "[ End ]" << endl;
+	return same ? 0 : -1;
+}
+
 int parser_test(string filename) {
 	cout << "[ Parser Test ]" << endl;
 	shared_ptr<Input> input = Input::open_file(filename);
@@ -114,6 +234,124 @@ int parser_test(string filename) {
 	return 0;
 }
 
+int parser_pipeline_test(string filename) {
+	cout << "[ Pipelined Parser Test ]" << endl;
+	
+	// same as the parser test, with the scanner on its own thread
+	InputPtr input = Input::open_file(filename);
+	if (input == nullptr) {
+		return -1;
+	}
+	ScannerPtr scanner = ScannerPtr(new Scanner(input));
+	SemanticAnalyzerPtr analyzer = SemanticAnalyzerPtr(new SemanticAnalyzer(filename));
+	ParserPtr parser = ParserPtr(new Parser(scanner, analyzer));
+	parser->set_pipelined(true);
+	parser->parse();
+	parser->get_analyzer()->get_ast()->display_tree();
+	cout << "[ End ]" << endl;
+	return 0;
+}
+
+int parser_table_test(string filename) {
+	cout << "[ Table Driven Parser Test ]" << endl;
+	
+	// same as the parser test, parsed from the predict table
+	InputPtr input = Input::open_file(filename);
+	if (input == nullptr) {
+		return -1;
+	}
+	ScannerPtr scanner = ScannerPtr(new Scanner(input));
+	SemanticAnalyzerPtr analyzer = SemanticAnalyzerPtr(new SemanticAnalyzer(filename));
+	ParserPtr parser = ParserPtr(new Parser(scanner, analyzer));
+	parser->set_table_driven(true);
+	parser->parse();
+	parser->get_analyzer()->get_ast()->display_tree();
+	cout << "[ End ]" << endl;
+	return 0;
+}
+
+int parser_trace_test(string filename) {
+	cout << "[ Parser Trace Test ]" << endl;
+	
+	// parse, then decode the events the parser recorded
+	#if PARSE_TRACE
+	InputPtr input = Input::open_file(filename);
+	if (input == nullptr) {
+		return -1;
+	}
+	ScannerPtr scanner = ScannerPtr(new Scanner(input));
+	SemanticAnalyzerPtr analyzer = SemanticAnalyzerPtr(new SemanticAnalyzer(filename));
+	ParserPtr parser = ParserPtr(new Parser(scanner, analyzer));
+	parser->parse();
+	parser->get_trace().display(input);
+	report_msg_type("Trace", to_string(parser->get_trace().get_recorded()) + " events recorded");
+	#else
+	report_msg_type("Trace", "Tracing is not built in, set PARSE_TRACE to 1 to trace " + filename);
+	#endif
+	cout << "[ End ]" << endl;
+	return 0;
+}
+
+int grammar_table_test() {
+	cout << "[ Grammar Table Test ]" << endl;
+	
+	// list the productions and the tokens that predict them
+	GrammarPtr grammar = Grammar::get_mikropascal();
+	grammar->display_table();
+	report_msg_type("Grammar", to_string(grammar->get_production_count()) + " productions, "
+					+ to_string(grammar->get_symbol_count()) + " symbols");
+	cout << "[ End ]" << endl;
+	return 0;
+}
+
+int expression_test(string expression) {
+	cout << "[ Expression Test ]" << endl;
+	
+	// parse the expression as the right side of an assignment,
+	// and list the tree its code block was handed, in postfix
+	ScannerPtr scanner = ScannerPtr(new Scanner(Input::open_string("program e;\nbegin\nx := "
+																	+ expression + "\nend.\n")));
+	SemanticAnalyzerPtr analyzer = SemanticAnalyzerPtr(new SemanticAnalyzer("e.pas"));
+	ParserPtr parser = ParserPtr(new Parser(scanner, analyzer));
+	parser->parse();
+	CodeBlockListPtr blocks = analyzer->get_top_block()->get_block_list();
+	for (auto i = blocks->begin(); i != blocks->end(); i++) {
+		if ((*i)->get_block_type() == ASSIGNMENT_BLOCK) {
+			ExpressionListPtr expressions = (*i)->get_expressions();
+			for (auto j = expressions->begin(); j != expressions->end(); j++) {
+				(*j)->display_tree();
+				report_msg_type("Nodes", to_string((*j)->size()));
+			}
+		}
+	}
+	cout << "[ End ]" << endl;
+	return 0;
+}
+
+int flat_tree_test(string filename) {
+	cout << "[ Flat Tree Test ]" << endl;
+	
+	// parse, then list the flattened tree and count
+	// its rules and literals in one pass
+	InputPtr input = Input::open_file(filename);
+	if (input == nullptr) {
+		return -1;
+	}
+	ScannerPtr scanner = ScannerPtr(new Scanner(input));
+	SemanticAnalyzerPtr analyzer = SemanticAnalyzerPtr(new SemanticAnalyzer(filename));
+	ParserPtr parser = ParserPtr(new Parser(scanner, analyzer));
+	parser->parse();
+	FlatTreePtr flat = analyzer->get_ast()->flatten();
+	flat->display_tree();
+	size_t rules = 0;
+	flat->visit(0, [&flat, &rules](size_t i) {
+		rules += flat->get_is_rule(i) ? 1 : 0;
+	});
+	cout << "Rules: " << rules << " Literals: " << flat->size() - rules << endl;
+	cout << "[ End ]" << endl;
+	return 0;
+}
+
 int symbol_test(string filename) {
 	cout << "[ Symbol Table Test ]" << endl;
 	shared_ptr<Input> input = Input::open_file(filename);
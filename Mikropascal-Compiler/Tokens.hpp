@@ -2,6 +2,8 @@
 #define TOKENS_HPP_
 
 #include "Standard.hpp"
+#include "Helper.hpp"
+#include "Input.hpp"
 
 enum TokType {
 
@@ -261,61 +263,213 @@ static TokType get_token_by_name(string name) {
 	return MP_ERROR;
 }
 
-// Token class
+// one slot of the keyword hash, empty slots have no text
+struct KeywordSlot {
+	const char* text;
+	TokType token;
+};
+
+// perfect hash over the reserved words that are spelled with
+// letters, every one of them lands in its own slot so a scanned
+// identifier needs one probe and one compare to classify it. the
+// factors and slots are searched for by Scanner::build_keywords
+// and baked into ScannerTables.hpp with the DFA (see -g)
+struct KeywordHash {
+	enum { slot_count = 64 };
+	unsigned int min_length;
+	unsigned int max_length;
+	unsigned int factors[4];
+	const KeywordSlot* slots;
+	
+	// letters fold to lowercase, digits and underscores
+	// fold to bytes no reserved word contains
+	static inline unsigned int hash(const unsigned int* factors, const char* first, size_t length) {
+		return (unsigned int) (length * factors[0]
+			+ (unsigned char) (first[0] | 0x20) * factors[1]
+			+ (unsigned char) (first[length > 1] | 0x20) * factors[2]
+			+ (unsigned char) (first[length - 1] | 0x20) * factors[3]) & (slot_count - 1);
+	}
+	
+	// the reserved word an identifier spells, or MP_ID
+	inline TokType classify(const char* first, size_t length) const {
+		if (length < this->min_length || length > this->max_length) {
+			return MP_ID;
+		}
+		const KeywordSlot& slot = this->slots[hash(this->factors, first, length)];
+		// compare up to the slot's terminator, which a folded
+		// byte never equals, then make sure the lengths agree
+		for (size_t i = 0; i < length; i++) {
+			if ((char) (first[i] | 0x20) != slot.text[i]) {
+				return MP_ID;
+			}
+		}
+		if (slot.text[length] != '\0') {
+			return MP_ID;
+		}
+		return slot.token;
+	}
+};
+
+// error message for the scanner's error tokens
+static const char* get_token_error(TokType token) {
+	switch (token) {
+	case MP_RUN_STRING:
+		return "There is a run on string here";
+	case MP_RUN_COMMENT:
+		return "There is a run on comment here";
+	case MP_ERROR:
+		return "There is an unreconized token here";
+	default:
+		return "No Error";
+	}
+}
+
+// interned names, every distinct lowercase name is stored
+// once and tokens refer to it by a small integer id
+class NameTable {
+private:
+	vector<string> names;
+	unordered_map<string, uint32_t> ids;
+	string scratch;
+public:
+	enum NameId : uint32_t { no_name = 0xFFFFFFFF };
+	uint32_t intern(const string& name) {
+		auto found = this->ids.find(name);
+		if (found != this->ids.end()) {
+			return found->second;
+		}
+		uint32_t id = (uint32_t) this->names.size();
+		this->names.push_back(name);
+		this->ids.emplace(name, id);
+		return id;
+	}
+	uint32_t intern_lower(const char* first, size_t length) {
+		// lowercase into a reused buffer, so looking up a
+		// name that is already interned does not allocate
+		this->scratch.assign(first, length);
+		for (size_t i = 0; i < length; i++) {
+			this->scratch[i] = (char) tolower(this->scratch[i]);
+		}
+		return this->intern(this->scratch);
+	}
+	const string& get_name(uint32_t id) {
+		return this->names[id];
+	}
+	size_t size() {
+		return this->names.size();
+	}
+	// names shared by every token in the program
+	static NameTable& global() {
+		static NameTable table;
+		return table;
+	}
+};
+
+// Token class, a compact plain record pointing back into the
+// source buffer, the lexeme and position are only built on demand.
+// it has no virtual members, so records are copied by value
 class Token {
 private:
-	unsigned long line;
-	unsigned long column;
-	TokType token;
-	string lexeme;
-    string error;
+	Input* source;
+	uint32_t offset;
+	uint32_t length;
+	uint32_t name_id;
+	uint32_t line;
+	uint32_t column;
+	uint8_t token;
 public:
 	Token(TokType token, string lexeme, unsigned long line, unsigned long column):
-			line(line), column(column), token(token), lexeme(lexeme) {
-	}
-    Token() {
-        this->line = 1L;
-        this->column = 1L;
-        this->token = MP_ERROR;
-        this->lexeme = "No Token";
-        this->error = "No Error";
-    }
-    
-    Token(const Token& other) : line(other.line), column(other.column), token(other.token),
-    lexeme(other.lexeme), error(other.error){};
-    
-	virtual ~Token() = default;
+			source(nullptr), offset(0), length((uint32_t) lexeme.size()),
+			name_id(NameTable::global().intern(lexeme)),
+			line((uint32_t) line), column((uint32_t) column), token((uint8_t) token) {
+	}
+	Token(Input* source, TokType token, uint32_t offset, uint32_t length, uint32_t name_id):
+			source(source), offset(offset), length(length), name_id(name_id),
+			line(1), column(1), token((uint8_t) token) {
+	}
+	Token() {
+		this->source = nullptr;
+		this->offset = 0;
+		this->length = 0;
+		this->name_id = NameTable::no_name;
+		this->line = 1;
+		this->column = 1;
+		this->token = (uint8_t) MP_ERROR;
+	}
+	
 	void set_line(unsigned long line) {
-		this->line = line;
+		this->line = (uint32_t) line;
 	}
 	void set_column(unsigned long column) {
-		this->column = column;
+		this->column = (uint32_t) column;
 	}
 	void set_token(TokType token) {
-		this->token = token;
+		this->token = (uint8_t) token;
+	}
+	void set_source(Input* source, size_t offset, size_t length) {
+		// the token's text is source[offset, offset + length),
+		// its line and column come from the source's line index
+		this->source = source;
+		this->offset = (uint32_t) offset;
+		this->length = (uint32_t) length;
+	}
+	void set_name_id(uint32_t name_id) {
+		this->name_id = name_id;
 	}
 	void set_lexeme(string lexeme) {
-		this->lexeme = lexeme;
+		// detach from the source, keep an interned copy instead
+		this->source = nullptr;
+		this->offset = 0;
+		this->length = (uint32_t) lexeme.size();
+		this->name_id = NameTable::global().intern(lexeme);
 	}
-    void set_error(string error_msg) {
-        this->error = error_msg;
-    }
 	unsigned long get_line() {
+		if (this->source != nullptr) {
+			return this->source->get_line(this->offset);
+		}
 		return this->line;
 	}
 	unsigned long get_column() {
+		if (this->source != nullptr) {
+			return this->source->get_column(this->offset);
+		}
 		return this->column;
 	}
 	TokType get_token() {
-		return this->token;
+		return (TokType) this->token;
+	}
+	uint32_t get_offset() {
+		return this->offset;
+	}
+	uint32_t get_length() {
+		return this->length;
+	}
+	uint32_t get_name_id() {
+		return this->name_id;
+	}
+	string get_text() {
+		// the token as written in the source
+		if (this->source != nullptr) {
+			return string(this->source->get_view().begin() + this->offset, this->length);
+		}
+		if (this->name_id != NameTable::no_name) {
+			return NameTable::global().get_name(this->name_id);
+		}
+		return string();
 	}
 	string get_lexeme() {
-		return this->lexeme;
+		// lowercase lexeme, interned names are lowercase already
+		if (this->name_id != NameTable::no_name) {
+			return NameTable::global().get_name(this->name_id);
+		}
+		string lexeme = this->get_text();
+		return to_lower(lexeme);
+	}
+	string get_error() {
+		// errors are known from the kind alone
+		return string(get_token_error(this->get_token()));
 	}
-    string get_error() {
-        return this->error;
-    }
-    // wary about this, repeal and replace...
+	// wary about this, repeal and replace...
 	shared_ptr<string> to_string() {
 		stringstream ss;
 		if (this->token == TokType::MP_RUN_COMMENT
@@ -326,7 +480,7 @@ public:
 			ss << setw(25) << std::left
 					<< get_token_info(this->get_token()).first << setw(10)
 					<< std::left << this->get_line() << setw(10) << std::left
-					<< (this->get_column() - this->get_lexeme().size())
+					<< (this->get_column() - this->get_length())
 					<< setw(30) << std::left
 					<< string("'" + this->get_lexeme() + "'");
 		}
@@ -334,4 +488,409 @@ public:
 	}
 };
 
+class TokenStream;
+class TokenRing;
+using TokenPtr = shared_ptr<Token>;
+using TokenStreamPtr = shared_ptr<TokenStream>;
+using TokenRingPtr = shared_ptr<TokenRing>;
+
+// materialized tokens are carved out of shared blocks, and
+// each block keeps the input of its tokens alive
+class TokenBlocks {
+private:
+	enum { token_block_size = 1024 };
+	shared_ptr<Token> token_block;
+	unsigned int token_block_used;
+	Input* block_input;
+public:
+	TokenBlocks(): token_block(nullptr), token_block_used(0), block_input(nullptr) {
+	}
+	TokenPtr make_token(const InputPtr& input, TokType kind, uint32_t offset,
+						uint32_t length, uint32_t name_id) {
+		// build a token record for the places that hold on to one
+		if (this->token_block == nullptr
+			|| this->token_block_used == token_block_size
+			|| this->block_input != input.get()) {
+			InputPtr owner = input;
+			this->token_block = shared_ptr<Token>(new Token[token_block_size],
+												  [owner](Token* block) { delete[] block; });
+			this->token_block_used = 0;
+			this->block_input = input.get();
+		}
+		Token* next = this->token_block.get() + this->token_block_used++;
+		*next = Token(input.get(), kind, offset, length, name_id);
+		return TokenPtr(this->token_block, next);
+	}
+};
+
+// scanned tokens stored column-wise, each field in its own
+// contiguous array and every token addressed by its index,
+// comments are dropped on the way in unless asked to keep them
+class TokenStream {
+private:
+	// the input every offset points into
+	InputPtr input;
+	const char* source;
+	bool keep_comments;
+	
+	// one entry per token in each
+	vector<uint8_t> kinds;
+	vector<uint32_t> offsets;
+	vector<uint32_t> lengths;
+	vector<uint32_t> name_ids;
+	
+	// the offsets from shift_from on are still to be moved by shift,
+	// so an edit moves this boundary rather than every later offset
+	size_t shift_from;
+	uint32_t shift;
+	uint32_t offset_at(size_t index) {
+		return (index >= this->shift_from) ? this->offsets[index] + this->shift : this->offsets[index];
+	}
+	void move_shift(size_t index) {
+		// put the boundary at index, settling the offsets it passes
+		for (; this->shift_from < index; this->shift_from++) {
+			this->offsets[this->shift_from] += this->shift;
+		}
+		for (; this->shift_from > index; this->shift_from--) {
+			this->offsets[this->shift_from - 1] -= this->shift;
+		}
+	}
+	// the indices of the comments and strings that ran on, in order.
+	// they are scan errors so there are few, and a rescan needs the
+	// first one without looking through every token before an edit
+	vector<size_t> run_ons;
+	void note_run_on(TokType token, size_t index) {
+		if (token == MP_RUN_COMMENT || token == MP_RUN_STRING) {
+			this->run_ons.push_back(index);
+		}
+	}
+	template <typename T> static void splice(vector<T>& column, size_t first, size_t removed,
+											 const vector<T>& other, size_t count) {
+		// overwrite what an edit kept the count of, and only
+		// move the rest of the column when the count changed
+		size_t kept = min(removed, count);
+		copy(other.begin(), other.begin() + kept, column.begin() + first);
+		if (removed > count) {
+			column.erase(column.begin() + first + kept, column.begin() + first + removed);
+		} else if (count > removed) {
+			column.insert(column.begin() + first + kept, other.begin() + kept, other.begin() + count);
+		}
+	}
+	
+	// materialized tokens
+	TokenBlocks blocks;
+public:
+	enum Index : size_t { filtered = SIZE_MAX };
+	TokenStream(InputPtr input):
+			input(input), source(input->get_view().begin()), keep_comments(false),
+			shift_from(0), shift(0) {
+	}
+	virtual ~TokenStream() = default;
+	void set_input(InputPtr input) {
+		// start over on another input, tokens already handed
+		// out keep the old one alive through their block
+		this->clear();
+		this->input = input;
+		this->source = input->get_view().begin();
+	}
+	void move_input(InputPtr input) {
+		// keep the tokens over an edited input, their
+		// offsets must already be right for it
+		this->input = input;
+		this->source = input->get_view().begin();
+	}
+	void set_keep_comments(bool keep_comments) {
+		this->keep_comments = keep_comments;
+	}
+	bool get_keep_comments() {
+		return this->keep_comments;
+	}
+	size_t append(TokType token, size_t offset, size_t length, uint32_t name_id) {
+		// add a token, returning its index
+		if (token == MP_COMMENT && !this->keep_comments) {
+			return filtered;
+		}
+		// the back is always past the shift boundary
+		this->kinds.push_back((uint8_t) token);
+		this->offsets.push_back((uint32_t) offset - this->shift);
+		this->lengths.push_back((uint32_t) length);
+		this->name_ids.push_back(name_id);
+		this->note_run_on(token, this->kinds.size() - 1);
+		return this->kinds.size() - 1;
+	}
+	void append_stream(TokenStream& other, size_t count, const vector<uint32_t>& name_map) {
+		// append the first count tokens of another stream over the
+		// same input, moving its name ids over to the ids in name_map
+		for (size_t i = 0; i < count; i++) {
+			uint32_t name_id = other.name_ids[i];
+			if (name_id != NameTable::no_name) {
+				name_id = name_map[name_id];
+			}
+			this->kinds.push_back(other.kinds[i]);
+			this->offsets.push_back(other.offset_at(i) - this->shift);
+			this->lengths.push_back(other.lengths[i]);
+			this->name_ids.push_back(name_id);
+			this->note_run_on((TokType) other.kinds[i], this->kinds.size() - 1);
+		}
+	}
+	void replace(size_t first, size_t removed, TokenStream& other, size_t count, int64_t shift) {
+		// put the first count tokens of another stream over the same
+		// input in place of removed tokens. the offsets of the tokens
+		// after them are moved by shift lazily, only the ones between
+		// this edit and the last are settled
+		other.move_shift(other.size());
+		this->move_shift(first + removed);
+		TokenStream::splice(this->kinds, first, removed, other.kinds, count);
+		TokenStream::splice(this->offsets, first, removed, other.offsets, count);
+		TokenStream::splice(this->lengths, first, removed, other.lengths, count);
+		TokenStream::splice(this->name_ids, first, removed, other.name_ids, count);
+		this->shift_from = first + count;
+		this->shift += (uint32_t) shift;
+		
+		// the run ons in the removed tokens go, the other stream's
+		// take their place and the ones after them move along
+		auto from = lower_bound(this->run_ons.begin(), this->run_ons.end(), first);
+		auto to = lower_bound(from, this->run_ons.end(), first + removed);
+		for (auto i = to; i != this->run_ons.end(); i++) {
+			*i = *i - removed + count;
+		}
+		auto other_to = lower_bound(other.run_ons.begin(), other.run_ons.end(), count);
+		vector<size_t> added;
+		for (auto i = other.run_ons.begin(); i != other_to; i++) {
+			added.push_back(first + *i);
+		}
+		from = this->run_ons.erase(from, to);
+		this->run_ons.insert(from, added.begin(), added.end());
+	}
+	void remove_kind(TokType token) {
+		// drop every token of one kind in a single pass
+		this->move_shift(this->size());
+		this->shift_from = 0;
+		this->shift = 0;
+		this->run_ons.clear();
+		size_t kept = 0;
+		for (size_t i = 0; i < this->kinds.size(); i++) {
+			if (this->kinds[i] != (uint8_t) token) {
+				this->kinds[kept] = this->kinds[i];
+				this->offsets[kept] = this->offsets[i];
+				this->lengths[kept] = this->lengths[i];
+				this->name_ids[kept] = this->name_ids[i];
+				this->note_run_on((TokType) this->kinds[kept], kept);
+				kept++;
+			}
+		}
+		this->kinds.resize(kept);
+		this->offsets.resize(kept);
+		this->lengths.resize(kept);
+		this->name_ids.resize(kept);
+	}
+	void clear() {
+		this->kinds.clear();
+		this->offsets.clear();
+		this->lengths.clear();
+		this->name_ids.clear();
+		this->run_ons.clear();
+		this->shift_from = 0;
+		this->shift = 0;
+	}
+	size_t size() {
+		return this->kinds.size();
+	}
+	size_t get_first_run_on() {
+		// the index of the first comment or string that ran on
+		return this->run_ons.empty() ? (size_t) filtered : this->run_ons.front();
+	}
+	bool empty() {
+		return this->kinds.empty();
+	}
+	TokType get_kind(size_t index) {
+		return (TokType) this->kinds[index];
+	}
+	uint32_t get_offset(size_t index) {
+		return this->offset_at(index);
+	}
+	uint32_t get_length(size_t index) {
+		return this->lengths[index];
+	}
+	uint32_t get_name_id(size_t index) {
+		return this->name_ids[index];
+	}
+	unsigned long get_line(size_t index) {
+		// looked up in the input's line index when asked for
+		return this->input->get_line(this->offset_at(index));
+	}
+	unsigned long get_column(size_t index) {
+		return this->input->get_column(this->offset_at(index));
+	}
+	string get_lexeme(size_t index) {
+		// lowercase lexeme without building a token
+		if (this->name_ids[index] != NameTable::no_name) {
+			return NameTable::global().get_name(this->name_ids[index]);
+		}
+		string lexeme = string(this->source + this->offset_at(index), this->lengths[index]);
+		return to_lower(lexeme);
+	}
+	Token get_record(size_t index) {
+		// a token record by value, nothing is allocated or counted
+		return Token(this->input.get(), this->get_kind(index), this->offset_at(index),
+					 this->lengths[index], this->name_ids[index]);
+	}
+	TokenPtr get_token(size_t index) {
+		// build a token record for the places that hold on to one
+		return this->blocks.make_token(this->input, this->get_kind(index), this->offset_at(index),
+									   this->lengths[index], this->name_ids[index]);
+	}
+};
+
+// a fixed number of scanned tokens waiting to be parsed, stored
+// column-wise like a stream. the scanner refills it in batches and
+// the parser takes tokens off the front, so memory stays the same
+// however long the input is
+class TokenRing {
+private:
+	InputPtr input;
+	
+	// one slot per token in each, the capacity is a power of two
+	vector<uint8_t> kinds;
+	vector<uint32_t> offsets;
+	vector<uint32_t> lengths;
+	vector<uint32_t> name_ids;
+	size_t mask;
+	size_t head;
+	size_t count;
+	
+	// tokens popped so far, the front's place in the whole input
+	size_t position;
+	
+	// errors found while scanning into the ring wait here until the
+	// front reaches the token they come before
+	TokenStream held_errors;
+	vector<size_t> held_positions;
+	size_t held_reported;
+	
+	// materialized tokens
+	TokenBlocks blocks;
+	
+	size_t slot(size_t index) {
+		return (this->head + index) & this->mask;
+	}
+public:
+	TokenRing(InputPtr input, size_t capacity):
+			input(input), head(0), count(0), position(0),
+			held_errors(input), held_reported(0) {
+		size_t rounded = 1;
+		while (rounded < capacity) {
+			rounded <<= 1;
+		}
+		this->kinds = vector<uint8_t>(rounded);
+		this->offsets = vector<uint32_t>(rounded);
+		this->lengths = vector<uint32_t>(rounded);
+		this->name_ids = vector<uint32_t>(rounded);
+		this->mask = rounded - 1;
+	}
+	virtual ~TokenRing() = default;
+	size_t capacity() {
+		return this->mask + 1;
+	}
+	size_t size() {
+		return this->count;
+	}
+	bool empty() {
+		return this->count == 0;
+	}
+	bool full() {
+		return this->count == this->mask + 1;
+	}
+	void push(TokType token, size_t offset, size_t length, uint32_t name_id) {
+		// add a token at the back, the ring must not be full
+		size_t back = this->slot(this->count++);
+		this->kinds[back] = (uint8_t) token;
+		this->offsets[back] = (uint32_t) offset;
+		this->lengths[back] = (uint32_t) length;
+		this->name_ids[back] = name_id;
+	}
+	void pop() {
+		// drop the token at the front
+		this->head = (this->head + 1) & this->mask;
+		this->count--;
+		this->position++;
+	}
+	void clear() {
+		this->head = 0;
+		this->count = 0;
+		this->position = 0;
+		this->held_errors.clear();
+		this->held_positions.clear();
+		this->held_reported = 0;
+	}
+	size_t get_position() {
+		return this->position;
+	}
+	void hold_error(TokType token, size_t offset, size_t length) {
+		// an error coming before the next token pushed
+		this->held_errors.append(token, offset, length, NameTable::no_name);
+		this->held_positions.push_back(this->position + this->count);
+	}
+	TokenStream& get_held_errors() {
+		return this->held_errors;
+	}
+	size_t next_held_error() {
+		// index of the next held error the front has reached, or
+		// filtered once there are none, forgetting them all when
+		// every one has been handed out
+		if (this->held_reported < this->held_positions.size()
+			&& this->held_positions[this->held_reported] <= this->position) {
+			return this->held_reported++;
+		}
+		if (this->held_reported == this->held_positions.size()) {
+			this->held_errors.clear();
+			this->held_positions.clear();
+			this->held_reported = 0;
+		}
+		return TokenStream::filtered;
+	}
+	void remap_names(const vector<uint32_t>& name_map) {
+		// move the ring's name ids over to another name table
+		for (size_t i = 0; i < this->count; i++) {
+			size_t at = this->slot(i);
+			if (this->name_ids[at] != NameTable::no_name) {
+				this->name_ids[at] = name_map[this->name_ids[at]];
+			}
+		}
+	}
+	// tokens are looked at by their distance from the front
+	TokType get_kind(size_t index) {
+		return (TokType) this->kinds[this->slot(index)];
+	}
+	uint32_t get_offset(size_t index) {
+		return this->offsets[this->slot(index)];
+	}
+	uint32_t get_length(size_t index) {
+		return this->lengths[this->slot(index)];
+	}
+	uint32_t get_name_id(size_t index) {
+		return this->name_ids[this->slot(index)];
+	}
+	unsigned long get_line(size_t index) {
+		return this->input->get_line(this->get_offset(index));
+	}
+	unsigned long get_column(size_t index) {
+		return this->input->get_column(this->get_offset(index));
+	}
+	InputPtr get_input() {
+		return this->input;
+	}
+	Token get_record(size_t index) {
+		// a token record by value, for the parser's hot path
+		size_t at = this->slot(index);
+		return Token(this->input.get(), (TokType) this->kinds[at], this->offsets[at],
+					 this->lengths[at], this->name_ids[at]);
+	}
+	TokenPtr get_token(size_t index) {
+		size_t at = this->slot(index);
+		return this->blocks.make_token(this->input, (TokType) this->kinds[at], this->offsets[at],
+									   this->lengths[at], this->name_ids[at]);
+	}
+};
+
 #endif /* TOKENS_HPP_ */